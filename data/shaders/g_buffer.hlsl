@@ -88,8 +88,12 @@ PixelInputType mainVS(Vertex_PosUvNorTan input, uint instance_id : SV_InstanceID
     output.position_ss_current  = output.position;
     output.position_ss_previous = compute_screen_space_position(input, instance_id, pass_get_transform_previous(), buffer_frame.view_projection_previous, output.position_world);
     // normals
-    output.normal_world  = normalize(mul(input.normal,  (float3x3)buffer_pass.transform)).xyz;
-    output.tangent_world = normalize(mul(input.tangent, (float3x3)buffer_pass.transform)).xyz;
+    float3x3 transform_normal = (float3x3)buffer_pass.transform;
+    #if INSTANCED
+    transform_normal = mul(transform_normal, (float3x3)input.instance_transform);
+    #endif
+    output.normal_world  = normalize(mul(input.normal,  transform_normal)).xyz;
+    output.tangent_world = normalize(mul(input.tangent, transform_normal)).xyz;
     // uv
     output.uv = input.uv;
     
@@ -104,6 +104,11 @@ namespace
                     "Optimize overdraw (slower import)",
                     "Minimize overdraw by reordering triangles, aiming to reduce pixel shader invocations"
                 );
+
+                mesh_import_dialog_checkbox(MeshFlags::GenerateLods,
+                    "Generate LODs (slower import)",
+                    "Simplify the mesh into progressively coarser versions, which are drawn when it's small on screen"
+                );
     
                 // Ok button
                 if (ImGuiSp::button_centered_on_line("Ok", 0.5f))
@@ -72,7 +72,7 @@ void ResourceViewer::OnTickVisible()
         ImGuiTableFlags_ScrollY;              // Enable vertical scrolling. Require 'outer_size' parameter of BeginTable() to specify the container size.
 
     static ImVec2 size = ImVec2(-1.0f);
-    if (ImGui::BeginTable("##Widget_ResourceCache", 7, flags, size))
+    if (ImGui::BeginTable("##Widget_ResourceCache", 9, flags, size))
     {
         // Headers
         ImGui::TableSetupColumn("Type");
@@ -82,6 +82,8 @@ void ResourceViewer::OnTickVisible()
         ImGui::TableSetupColumn("Path (native)");
         ImGui::TableSetupColumn("Size CPU");
         ImGui::TableSetupColumn("Size GPU");
+        ImGui::TableSetupColumn("Size on disk");
+        ImGui::TableSetupColumn("Size on disk (uncompressed)");
         ImGui::TableHeadersRow();
 
         for (const shared_ptr<IResource>& resource : resources)
@@ -118,6 +120,14 @@ void ResourceViewer::OnTickVisible()
                 // Memory GPU
                 ImGui::TableSetColumnIndex(6);
                 print_memory(object->GetObjectSizeGpu());
+
+                // Disk
+                ImGui::TableSetColumnIndex(7);
+                print_memory(resource->GetFileSize());
+
+                // Disk (uncompressed)
+                ImGui::TableSetColumnIndex(8);
+                print_memory(resource->GetFileSizeUncompressed());
             }
         }
 
@@ -109,6 +109,7 @@ namespace Spartan
         Physics::Tick();
         World::Tick();
         Renderer::Tick();
+        ResourceCache::Tick();
 
         // post-tick
         Input::PostTick();
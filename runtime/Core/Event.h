@@ -72,6 +72,7 @@ namespace Spartan
         WorldClear,                    // The world is about to clear everything
         WorldResolve,                  // The world is resolving
         WorldResolved,                 // The world has finished resolving
+        WorldChanged,                  // Entities were added, removed or modified since the last resolve (incremental)
         // SDL                         
         Sdl,                           // An SDL event
         // Window                      
@@ -81,11 +82,24 @@ namespace Spartan
 
     class Entity;
 
+    enum class WorldChangeType : uint8_t
+    {
+        Added,
+        Removed,
+        Modified // components were added or removed
+    };
+
+    struct WorldChange
+    {
+        std::shared_ptr<Entity> entity;
+        WorldChangeType type = WorldChangeType::Modified;
+    };
+
     using sp_variant = std::variant<
         int,
         void*,
-        std::vector<std::shared_ptr<Entity>>
-
+        std::vector<std::shared_ptr<Entity>>,
+        std::vector<WorldChange>
     >;
     using subscriber = std::function<void(const sp_variant&)>;
 
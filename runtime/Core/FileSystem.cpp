@@ -653,4 +653,19 @@ namespace Spartan
             return true;
         }
     }
+
+    bool FileSystem::Rename(const string& source, const string& destination)
+    {
+        try
+        {
+            // replaces the destination if it exists
+            filesystem::rename(source, destination);
+            return true;
+        }
+        catch (filesystem::filesystem_error& e)
+        {
+            SP_LOG_ERROR("%s", e.what());
+            return false;
+        }
+    }
 }
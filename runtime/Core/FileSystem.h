@@ -88,6 +88,7 @@ namespace Spartan
         static bool Delete(const std::string& path);
         static bool CreateDirectory(const std::string& path);
         static bool CopyFileFromTo(const std::string& source, const std::string& destination);
+        static bool Rename(const std::string& source, const std::string& destination);
     };
 
     static const char* EXTENSION_WORLD    = ".world";
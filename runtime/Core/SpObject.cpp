@@ -37,9 +37,29 @@ namespace Spartan
         m_object_id = GenerateObjectId();
     }
 
+    void SpObject::SetObjectName(const string& name)
+    {
+        if (name == m_object_name)
+            return;
+
+        const string name_previous = move(m_object_name);
+        m_object_name              = name;
+        OnObjectNameChanged(name_previous);
+    }
+
+    void SpObject::SetObjectId(const uint64_t id)
+    {
+        if (id == m_object_id)
+            return;
+
+        const uint64_t id_previous = m_object_id;
+        m_object_id                = id;
+        OnObjectIdChanged(id_previous);
+    }
+
     uint64_t SpObject::GenerateObjectId()
     {
-        static mt19937_64 eng{ random_device{}() };
+        static thread_local mt19937_64 eng{ random_device{}() }; // objects are created on many threads (e.g. world loading)
 
         auto time_now     = chrono::high_resolution_clock::now().time_since_epoch().count();
         auto thread_id    = hash<thread::id>()(this_thread::get_id());
@@ -35,14 +35,15 @@ namespace Spartan
     {
     public:
         SpObject();
+        virtual ~SpObject() = default;
         
         // name
-        const std::string& GetObjectName() const    { return m_object_name; }
-        void SetObjectName(const std::string& name) { m_object_name = name; }
+        const std::string& GetObjectName() const { return m_object_name; }
+        void SetObjectName(const std::string& name);
 
         // id
-        const uint64_t GetObjectId() const  { return m_object_id; }
-        void SetObjectId(const uint64_t id) { m_object_id = id; }
+        const uint64_t GetObjectId() const { return m_object_id; }
+        void SetObjectId(uint64_t id);
         static uint64_t GenerateObjectId();
 
         // cpu & gpu sizes
@@ -50,6 +51,10 @@ namespace Spartan
         const uint64_t GetObjectSizeGpu() const { return m_object_size_gpu; }
 
     protected:
+        // called by the setters when the value actually changed, so that whatever indexes objects by it can follow
+        virtual void OnObjectNameChanged(const std::string& /*name_previous*/) {}
+        virtual void OnObjectIdChanged(uint64_t /*id_previous*/) {}
+
         std::string m_object_name;
         uint64_t m_object_id       = 0;
         uint64_t m_object_size_cpu = 0;
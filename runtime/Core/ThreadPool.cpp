@@ -30,53 +30,296 @@ using namespace std;
 
 namespace Spartan
 {
+    // Jobs which are connected (as children or continuations) share a graph, waiting on a job helps with the
+    // ready jobs of its graph only. Graphs which get connected later are merged, the absorbed one forwards to the other.
+    struct JobGraph
+    {
+        mutex mutex_ready;
+        deque<weak_ptr<Job>> ready;  // also queued in the pool, whoever starts a job first executes it
+        shared_ptr<JobGraph> merged; // guarded by mutex_ready
+    };
+
+    struct Job
+    {
+        Task task;
+        JobHandle parent;
+        shared_ptr<JobGraph> graph;
+        atomic<bool> started       = false;
+        atomic<int32_t> unfinished = 1; // the job itself plus its unfinished children
+        atomic<int32_t> pending    = 1; // Run() plus the unfinished jobs it's a continuation of
+        mutex mutex_continuations;
+        vector<JobHandle> continuations;
+        bool finished              = false; // guarded by mutex_continuations
+    };
+
     namespace
     {
+        struct TaskNode
+        {
+            Task task;
+            TaskNode* next = nullptr;
+            uint32_t owner = 0; // index of the pool that allocated this node
+        };
+
+        // Node pool, only the owning thread allocates but any thread can free.
+        // Freed nodes go to a lock-free stack which the owner reclaims in one go.
+        class TaskNodePool
+        {
+        public:
+            TaskNode* Allocate(const uint32_t owner)
+            {
+                if (!m_free_local)
+                {
+                    m_free_local = m_free_remote.exchange(nullptr, memory_order_acquire);
+                }
+
+                // grow, this only happens while the pool is warming up
+                if (!m_free_local)
+                {
+                    m_chunks.emplace_back(make_unique<TaskNode[]>(chunk_size));
+                    TaskNode* chunk = m_chunks.back().get();
+                    for (uint32_t i = 0; i < chunk_size; i++)
+                    {
+                        chunk[i].owner = owner;
+                        chunk[i].next  = m_free_local;
+                        m_free_local   = &chunk[i];
+                    }
+                }
+
+                TaskNode* node = m_free_local;
+                m_free_local   = node->next;
+                node->next     = nullptr;
+
+                return node;
+            }
+
+            void Free(TaskNode* node)
+            {
+                TaskNode* head = m_free_remote.load(memory_order_relaxed);
+                do
+                {
+                    node->next = head;
+                } while (!m_free_remote.compare_exchange_weak(head, node, memory_order_release, memory_order_relaxed));
+            }
+
+        private:
+            static constexpr uint32_t chunk_size = 256;
+            TaskNode* m_free_local = nullptr;
+            atomic<TaskNode*> m_free_remote = nullptr;
+            vector<unique_ptr<TaskNode[]>> m_chunks;
+        };
+
+        // Chase-Lev deque, the owner pushes and pops at the bottom, other threads steal from the top.
+        class WorkStealingDeque
+        {
+        public:
+            bool Push(TaskNode* node)
+            {
+                int64_t bottom = m_bottom.load(memory_order_relaxed);
+                int64_t top    = m_top.load(memory_order_acquire);
+                if (bottom - top >= capacity)
+                    return false;
+
+                m_buffer[bottom & mask].store(node, memory_order_relaxed);
+                m_bottom.store(bottom + 1, memory_order_release);
+
+                return true;
+            }
+
+            TaskNode* Pop()
+            {
+                int64_t bottom = m_bottom.load(memory_order_relaxed) - 1;
+                m_bottom.store(bottom, memory_order_relaxed);
+                atomic_thread_fence(memory_order_seq_cst);
+                int64_t top = m_top.load(memory_order_relaxed);
+
+                // empty
+                if (top > bottom)
+                {
+                    m_bottom.store(bottom + 1, memory_order_relaxed);
+                    return nullptr;
+                }
+
+                TaskNode* node = m_buffer[bottom & mask].load(memory_order_relaxed);
+
+                // last item, race against the stealers for it
+                if (top == bottom)
+                {
+                    if (!m_top.compare_exchange_strong(top, top + 1, memory_order_seq_cst, memory_order_relaxed))
+                    {
+                        node = nullptr;
+                    }
+                    m_bottom.store(bottom + 1, memory_order_relaxed);
+                }
+
+                return node;
+            }
+
+            TaskNode* Steal()
+            {
+                int64_t top = m_top.load(memory_order_acquire);
+                atomic_thread_fence(memory_order_seq_cst);
+                int64_t bottom = m_bottom.load(memory_order_acquire);
+
+                if (top >= bottom)
+                    return nullptr;
+
+                TaskNode* node = m_buffer[top & mask].load(memory_order_relaxed);
+                if (!m_top.compare_exchange_strong(top, top + 1, memory_order_seq_cst, memory_order_relaxed))
+                    return nullptr;
+
+                return node;
+            }
+
+        private:
+            static constexpr int64_t capacity = 4096;
+            static constexpr int64_t mask     = capacity - 1;
+            alignas(64) atomic<int64_t> m_top    = 0;
+            alignas(64) atomic<int64_t> m_bottom = 0;
+            array<atomic<TaskNode*>, capacity> m_buffer;
+        };
+
+        struct alignas(64) Worker
+        {
+            WorkStealingDeque deque;
+            TaskNodePool pool;
+        };
+
         // Stats
         static uint32_t thread_count                 = 0;
         static atomic<uint32_t> working_thread_count = 0;
 
         // Sync objects
-        static mutex mutex_tasks;
+        static mutex mutex_sleep;
         static condition_variable condition_var;
+        static atomic<uint32_t> sleeping_thread_count = 0;
 
         // Threads
         static vector<thread> threads;
 
-        // Tasks
-        static deque<Task> tasks;
+        // Workers, index 0 belongs to the thread that initialized the pool, the rest to the pool threads
+        static vector<unique_ptr<Worker>> workers;
+        static thread_local int32_t thread_index = -1;
+
+        // Tasks coming from threads that don't own a deque (or from a full deque)
+        static mutex mutex_tasks_external;
+        static deque<TaskNode*> tasks_external;
+        static TaskNodePool pool_external;
+        static atomic<uint32_t> tasks_external_count = 0;
+        static constexpr uint32_t pool_external_index = numeric_limits<uint32_t>::max();
+
+        // Task counts
+        static atomic<int32_t> tasks_pending    = 0; // queued
+        static atomic<int32_t> tasks_unfinished = 0; // queued or executing
 
         // Misc
-        static bool is_stopping;
+        static atomic<bool> is_stopping = false;
     }
 
-    static void thread_loop()
+    static void free_node(TaskNode* node)
     {
-        while (true)
+        if (node->owner == pool_external_index)
+        {
+            pool_external.Free(node);
+        }
+        else
         {
-            // Lock tasks mutex
-            unique_lock<mutex> lock(mutex_tasks);
+            workers[node->owner]->pool.Free(node);
+        }
+    }
 
-            // Check condition on notification
-            condition_var.wait(lock, [] { return !tasks.empty() || is_stopping; });
+    static void push_external(TaskNode* node)
+    {
+        lock_guard<mutex> lock(mutex_tasks_external);
+        tasks_external.push_back(node);
+        tasks_external_count++;
+    }
 
-            // If m_stopping is true, it's time to shut everything down
-            if (is_stopping && tasks.empty())
-                return;
+    static TaskNode* pop_external()
+    {
+        if (tasks_external_count == 0)
+            return nullptr;
 
-            // Get next task in the queue.
-            Task task = tasks.front();
+        lock_guard<mutex> lock(mutex_tasks_external);
+        if (tasks_external.empty())
+            return nullptr;
 
-            // Remove it from the queue.
-            tasks.pop_front();
+        TaskNode* node = tasks_external.front();
+        tasks_external.pop_front();
+        tasks_external_count--;
 
-            // Unlock the mutex
-            lock.unlock();
+        return node;
+    }
+
+    static TaskNode* acquire_task()
+    {
+        TaskNode* node = nullptr;
+
+        // own deque first, most recently pushed tasks are the most likely to be in cache
+        if (thread_index >= 0)
+        {
+            node = workers[thread_index]->deque.Pop();
+        }
+
+        // then steal from the other threads, starting with the next one to spread contention
+        if (!node)
+        {
+            const uint32_t worker_count = static_cast<uint32_t>(workers.size());
+            const uint32_t start        = static_cast<uint32_t>(thread_index + 1);
+            for (uint32_t i = 0; i < worker_count && !node; i++)
+            {
+                uint32_t victim = (start + i) % worker_count;
+                if (victim != static_cast<uint32_t>(thread_index))
+                {
+                    node = workers[victim]->deque.Steal();
+                }
+            }
+        }
 
-            // Execute the task.
-            working_thread_count++;
-            task();
-            working_thread_count--;
+        if (!node)
+        {
+            node = pop_external();
+        }
+
+        if (node)
+        {
+            tasks_pending--;
+        }
+
+        return node;
+    }
+
+    static void execute(TaskNode* node)
+    {
+        node->task();
+        node->task.Reset();
+        free_node(node);
+        tasks_unfinished--;
+    }
+
+    static void thread_loop(const uint32_t index)
+    {
+        thread_index = static_cast<int32_t>(index);
+
+        while (true)
+        {
+            if (TaskNode* node = acquire_task())
+            {
+                working_thread_count++;
+                execute(node);
+                working_thread_count--;
+                continue;
+            }
+
+            // nothing to steal, sleep until a task is added
+            unique_lock<mutex> lock(mutex_sleep);
+            sleeping_thread_count++;
+            condition_var.wait(lock, [] { return tasks_pending > 0 || is_stopping; });
+            sleeping_thread_count--;
+
+            // if is_stopping is true, it's time to shut everything down
+            if (is_stopping && tasks_pending == 0)
+                return;
         }
     }
 
@@ -84,11 +327,18 @@ namespace Spartan
     {
         is_stopping                      = false;
         uint32_t concurrent_thread_count = thread::hardware_concurrency();
-        thread_count                     = concurrent_thread_count - 1; // exclude the calling thread
+        thread_count                     = max(concurrent_thread_count, 2u) - 1; // exclude the calling thread, but always have one
+
+        // the calling thread gets a deque too, so that it can push without locking
+        for (uint32_t i = 0; i < thread_count + 1; i++)
+        {
+            workers.emplace_back(make_unique<Worker>());
+        }
+        thread_index = 0;
 
         for (uint32_t i = 0; i < thread_count; i++)
         {
-            threads.emplace_back(thread(&thread_loop));
+            threads.emplace_back(thread(&thread_loop, i + 1));
         }
 
         SP_LOG_INFO("%d threads have been created", thread_count);
@@ -98,14 +348,11 @@ namespace Spartan
     {
         Flush(true);
 
-        // Put unique lock on task mutex.
-        unique_lock<mutex> lock(mutex_tasks);
-
         // Set termination flag to true.
-        is_stopping = true;
-
-        // Unlock the mutex
-        lock.unlock();
+        {
+            lock_guard<mutex> lock(mutex_sleep);
+            is_stopping = true;
+        }
 
         // Wake up all threads.
         condition_var.notify_all();
@@ -118,61 +365,111 @@ namespace Spartan
 
         // Empty worker threads.
         threads.clear();
+        workers.clear();
+        thread_index = -1;
     }
 
     void ThreadPool::AddTask(Task&& task)
     {
-        // Lock tasks mutex
-        unique_lock<mutex> lock(mutex_tasks);
+        // count the task before it's visible so that a stealer can't decrement first
+        tasks_pending++;
+        tasks_unfinished++;
 
-        // Save the task
-        tasks.emplace_back(bind(forward<Task>(task)));
+        // save the task
+        if (thread_index >= 0)
+        {
+            Worker& worker = *workers[thread_index];
+            TaskNode* node = worker.pool.Allocate(static_cast<uint32_t>(thread_index));
+            node->task     = move(task);
 
-        // Unlock the mutex
-        lock.unlock();
+            if (!worker.deque.Push(node))
+            {
+                push_external(node);
+            }
+        }
+        else
+        {
+            lock_guard<mutex> lock(mutex_tasks_external);
+            TaskNode* node = pool_external.Allocate(pool_external_index);
+            node->task     = move(task);
+            tasks_external.push_back(node);
+            tasks_external_count++;
+        }
 
-        // Wake up a thread
-        condition_var.notify_one();
+        // wake up a thread
+        if (sleeping_thread_count > 0)
+        {
+            lock_guard<mutex> lock(mutex_sleep);
+            condition_var.notify_one();
+        }
     }
 
-    void ThreadPool::ParallelLoop(function<void(uint32_t work_index_start, uint32_t work_index_end)>&& function, const uint32_t work_total)
+    void ThreadPool::ParallelLoop(function<void(uint32_t work_index_start, uint32_t work_index_end)>&& function, const uint32_t work_total, const uint32_t grain_size /*= 0*/)
     {
-        SP_ASSERT_MSG(work_total > 1, "A parallel loop can't have a range of 1 or smaller");
+        if (work_total == 0)
+            return;
 
-        uint32_t available_threads = GetIdleThreadCount();
-        uint32_t work_per_thread   = work_total / available_threads;
-        uint32_t work_remainder    = work_total % available_threads;
-        uint32_t work_index        = 0;
-        atomic<uint32_t> work_done = 0;
-        condition_variable cv;
-        mutex cv_m;
+        // by default, aim for a few chunks per thread so that threads which finish early can balance the load
+        const uint32_t chunks_per_thread = 8;
+        const uint32_t thread_total      = thread_count + 1; // the calling thread helps
+        const uint32_t grain             = grain_size != 0 ? grain_size : max(work_total / (thread_total * chunks_per_thread), 1u);
 
-        // split work into multiple tasks
-        while (work_index < work_total)
+        // not worth splitting
+        if (work_total <= grain)
         {
-            uint32_t work_to_do = work_per_thread;
+            function(0, work_total);
+            return;
+        }
 
-            // if the work doesn't divide evenly across threads, add the remainder work to the first thread.
-            if (work_remainder != 0)
+        // shared with the helper tasks, which can outlive this call if they get executed after the work is done
+        struct loop_state
+        {
+            std::function<void(uint32_t, uint32_t)> function;
+            atomic<uint64_t> cursor    = 0; // 64-bit so that overshooting work_total can't wrap around
+            atomic<uint32_t> work_done = 0;
+            uint32_t work_total        = 0;
+            uint32_t grain             = 0;
+        };
+        shared_ptr<loop_state> state = make_shared<loop_state>();
+        state->function              = move(function);
+        state->work_total            = work_total;
+        state->grain                 = grain;
+
+        // claim chunks until there are none left
+        auto claim_and_execute = [](loop_state& state)
+        {
+            while (true)
             {
-                work_to_do     += work_remainder;
-                work_remainder = 0;
+                uint64_t claimed = state.cursor.fetch_add(state.grain);
+                if (claimed >= state.work_total)
+                    break;
+
+                uint32_t start = static_cast<uint32_t>(claimed);
+                uint32_t end   = static_cast<uint32_t>(min<uint64_t>(claimed + state.grain, state.work_total));
+                state.function(start, end);
+                state.work_done += end - start;
             }
+        };
 
-            AddTask([&function, &work_done, &cv, work_index, work_to_do]()
+        // wake up as many helpers as there are chunks left for them
+        const uint32_t chunk_count  = (work_total + grain - 1) / grain;
+        const uint32_t helper_count = min(thread_count, chunk_count - 1);
+        for (uint32_t i = 0; i < helper_count; i++)
+        {
+            AddTask([state, claim_and_execute]()
             {
-                function(work_index, work_index + work_to_do);
-                work_done += work_to_do;
-
-                cv.notify_one(); // notify that a thread has finished its work
+                claim_and_execute(*state);
             });
-
-            work_index += work_to_do;
         }
 
-        // wait for threads to finish work
-        unique_lock<mutex> lk(cv_m);
-        cv.wait(lk, [&]() { return work_done == work_total; });
+        claim_and_execute(*state);
+
+        // chunks claimed by other threads might still be executing, wait for them without picking up unrelated
+        // tasks, the caller could be holding locks that those tasks need (and nothing else is left to claim anyway)
+        while (state->work_done != work_total)
+        {
+            this_thread::yield();
+        }
     }
 
     void ThreadPool::Flush(bool remove_queued /*= false*/)
@@ -180,18 +477,229 @@ namespace Spartan
         // Clear any queued tasks
         if (remove_queued)
         {
-            tasks.clear();
+            auto discard = [](TaskNode* node)
+            {
+                node->task.Reset();
+                free_node(node);
+                tasks_pending--;
+                tasks_unfinished--;
+            };
+
+            for (unique_ptr<Worker>& worker : workers)
+            {
+                while (TaskNode* node = worker->deque.Steal())
+                {
+                    discard(node);
+                }
+            }
+
+            while (TaskNode* node = pop_external())
+            {
+                discard(node);
+            }
         }
 
-        // If so, wait for them
+        // wait for the pool threads to finish them, the caller could be holding locks that the tasks need
         while (AreTasksRunning())
         {
-            this_thread::sleep_for(chrono::milliseconds(16));
+            this_thread::yield();
+        }
+    }
+
+    static void graph_push(shared_ptr<JobGraph> graph, const JobHandle& job)
+    {
+        while (true)
+        {
+            unique_lock<mutex> lock(graph->mutex_ready);
+            if (!graph->merged)
+            {
+                graph->ready.emplace_back(job);
+                return;
+            }
+
+            shared_ptr<JobGraph> next = graph->merged;
+            lock.unlock();
+            graph = move(next);
+        }
+    }
+
+    static JobHandle graph_pop(shared_ptr<JobGraph> graph)
+    {
+        while (true)
+        {
+            unique_lock<mutex> lock(graph->mutex_ready);
+            if (!graph->merged)
+            {
+                while (!graph->ready.empty())
+                {
+                    JobHandle job = graph->ready.front().lock();
+                    graph->ready.pop_front();
+                    if (job && !job->started)
+                        return job;
+                }
+
+                return nullptr;
+            }
+
+            shared_ptr<JobGraph> next = graph->merged;
+            lock.unlock();
+            graph = move(next);
+        }
+    }
+
+    static shared_ptr<JobGraph> graph_resolve(shared_ptr<JobGraph> graph)
+    {
+        while (true)
+        {
+            lock_guard<mutex> lock(graph->mutex_ready);
+            if (!graph->merged)
+                return graph;
+
+            graph = graph->merged;
+        }
+    }
+
+    static void graph_merge(const shared_ptr<JobGraph>& a, const shared_ptr<JobGraph>& b)
+    {
+        while (true)
+        {
+            shared_ptr<JobGraph> into = graph_resolve(a);
+            shared_ptr<JobGraph> from = graph_resolve(b);
+            if (into == from)
+                return;
+
+            // either one could have been merged since it was resolved, if so, try again
+            scoped_lock lock(into->mutex_ready, from->mutex_ready);
+            if (into->merged || from->merged)
+                continue;
+
+            move(from->ready.begin(), from->ready.end(), back_inserter(into->ready));
+            from->ready.clear();
+            from->merged = into;
+            return;
+        }
+    }
+
+    static void schedule_job(const JobHandle& job);
+
+    static void finish_job(const JobHandle& job)
+    {
+        if (--job->unfinished != 0)
+            return;
+
+        // take the continuations, any continuation added from now on won't wait for this job
+        vector<JobHandle> continuations;
+        {
+            lock_guard<mutex> lock(job->mutex_continuations);
+            job->finished = true;
+            continuations.swap(job->continuations);
+        }
+
+        for (const JobHandle& continuation : continuations)
+        {
+            if (--continuation->pending == 0)
+            {
+                schedule_job(continuation);
+            }
+        }
+
+        // a finished child is one less thing for the parent to wait for
+        if (job->parent)
+        {
+            JobHandle parent = move(job->parent);
+            finish_job(parent);
+        }
+    }
+
+    static void execute_job(const JobHandle& job)
+    {
+        // a waiter of the job's graph might have started it already
+        if (job->started.exchange(true))
+            return;
+
+        job->task();
+        job->task.Reset();
+        finish_job(job);
+    }
+
+    static void schedule_job(const JobHandle& job)
+    {
+        graph_push(job->graph, job);
+        ThreadPool::AddTask([job]()
+        {
+            execute_job(job);
+        });
+    }
+
+    JobHandle ThreadPool::CreateJob(Task&& task, const JobHandle& parent /*= nullptr*/)
+    {
+        JobHandle job = make_shared<Job>();
+        job->task     = move(task);
+
+        if (parent)
+        {
+            SP_ASSERT_MSG(parent->unfinished > 0, "Children can't be added to a finished job");
+            parent->unfinished++;
+            job->parent = parent;
+            job->graph  = parent->graph;
+        }
+        else
+        {
+            job->graph = make_shared<JobGraph>();
+        }
+
+        return job;
+    }
+
+    void ThreadPool::AddContinuation(const JobHandle& job, const JobHandle& continuation)
+    {
+        SP_ASSERT(job != nullptr && continuation != nullptr);
+
+        graph_merge(job->graph, continuation->graph);
+
+        lock_guard<mutex> lock(job->mutex_continuations);
+        if (!job->finished)
+        {
+            continuation->pending++;
+            job->continuations.emplace_back(continuation);
         }
     }
 
+    void ThreadPool::Run(const JobHandle& job)
+    {
+        SP_ASSERT(job != nullptr);
+
+        if (--job->pending == 0)
+        {
+            schedule_job(job);
+        }
+    }
+
+    void ThreadPool::Wait(const JobHandle& job)
+    {
+        SP_ASSERT(job != nullptr);
+
+        // only jobs of the same graph are executed, the caller could be holding locks that unrelated tasks need
+        while (!IsDone(job))
+        {
+            if (JobHandle ready = graph_pop(job->graph))
+            {
+                execute_job(ready);
+            }
+            else
+            {
+                this_thread::yield();
+            }
+        }
+    }
+
+    bool ThreadPool::IsDone(const JobHandle& job)
+    {
+        return job->unfinished == 0;
+    }
+
     uint32_t ThreadPool::GetThreadCount()        { return thread_count; }
     uint32_t ThreadPool::GetWorkingThreadCount() { return working_thread_count; }
     uint32_t ThreadPool::GetIdleThreadCount()    { return thread_count - working_thread_count; }
-    bool ThreadPool::AreTasksRunning()           { return GetIdleThreadCount() != GetThreadCount(); }
+    bool ThreadPool::AreTasksRunning()           { return tasks_unfinished > 0; }
 }
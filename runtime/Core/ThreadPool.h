@@ -24,11 +24,97 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 //= INCLUDES ===========
 #include "Definitions.h"
 #include <functional>
+#include <memory>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
 //======================
 
 namespace Spartan
 {
-    using Task = std::function<void()>;
+    // A move-only callable with inline storage, tasks never allocate on the heap
+    class Task
+    {
+    public:
+        static constexpr size_t storage_size = 64;
+
+        Task() = default;
+
+        template<typename F, typename = std::enable_if_t<!std::is_same_v<std::decay_t<F>, Task>>>
+        Task(F&& function)
+        {
+            using T = std::decay_t<F>;
+            static_assert(sizeof(T) <= storage_size, "Task captures are too large, capture by pointer/reference instead");
+            static_assert(alignof(T) <= alignof(std::max_align_t), "Task captures are over-aligned");
+
+            new (m_storage) T(std::forward<F>(function));
+            m_invoke = [](void* storage) { (*static_cast<T*>(storage))(); };
+            m_manage = [](void* destination, void* source)
+            {
+                // move construct into the destination (if any) and destroy the source
+                if (destination)
+                {
+                    new (destination) T(std::move(*static_cast<T*>(source)));
+                }
+                static_cast<T*>(source)->~T();
+            };
+        }
+
+        Task(Task&& other) noexcept { MoveFrom(other); }
+
+        Task& operator=(Task&& other) noexcept
+        {
+            if (this != &other)
+            {
+                Reset();
+                MoveFrom(other);
+            }
+
+            return *this;
+        }
+
+        Task(const Task&)            = delete;
+        Task& operator=(const Task&) = delete;
+
+        ~Task() { Reset(); }
+
+        void operator()() { m_invoke(m_storage); }
+        explicit operator bool() const { return m_invoke != nullptr; }
+
+        void Reset()
+        {
+            if (m_manage)
+            {
+                m_manage(nullptr, m_storage);
+            }
+
+            m_invoke = nullptr;
+            m_manage = nullptr;
+        }
+
+    private:
+        void MoveFrom(Task& other)
+        {
+            if (other.m_manage)
+            {
+                other.m_manage(m_storage, other.m_storage);
+            }
+
+            m_invoke       = other.m_invoke;
+            m_manage       = other.m_manage;
+            other.m_invoke = nullptr;
+            other.m_manage = nullptr;
+        }
+
+        alignas(std::max_align_t) std::byte m_storage[storage_size];
+        void (*m_invoke)(void* storage)                   = nullptr;
+        void (*m_manage)(void* destination, void* source) = nullptr;
+    };
+
+    // A job is a task that can have children, dependencies and continuations
+    struct Job;
+    using JobHandle = std::shared_ptr<Job>;
 
     class SP_CLASS ThreadPool
     {
@@ -36,15 +122,30 @@ namespace Spartan
         static void Initialize();
         static void Shutdown();
 
-        // Add a task.
+        // Add a task, it goes to the calling thread's deque and idle threads steal it from there.
         static void AddTask(Task&& task);
 
-        // Adds multiple tasks to spread execution of a given function across all available threads.
-        static void ParallelLoop(std::function<void(uint32_t work_index_start, uint32_t work_index_end)>&& function, const uint32_t work_total);
+        // Spreads execution of a given function across all available threads, including the calling one.
+        // Threads claim chunks of grain_size work items until there are none left (0 picks a grain size automatically).
+        // It's safe to call from within a task, once there is nothing left to claim the caller waits for the other threads
+        // without executing unrelated tasks, so it's also safe to call while holding locks.
+        static void ParallelLoop(std::function<void(uint32_t work_index_start, uint32_t work_index_end)>&& function, const uint32_t work_total, const uint32_t grain_size = 0);
 
         // Wait for all threads to finish work
         static void Flush(bool remove_queued = false);
 
+        // Job graph
+        // A job doesn't execute until Run() has been called and all the jobs it's a continuation of have finished.
+        // A job with a parent keeps the parent unfinished until it finishes too, so create children before the parent finishes (e.g. from within its task).
+        static JobHandle CreateJob(Task&& task, const JobHandle& parent = nullptr);
+        // The continuation will execute once the job and all of its children have finished, call before running the continuation.
+        // Both end up in the same graph.
+        static void AddContinuation(const JobHandle& job, const JobHandle& continuation);
+        static void Run(const JobHandle& job);
+        // Waits for the job and all of its children to finish, ready jobs of the same graph are executed in the meantime.
+        static void Wait(const JobHandle& job);
+        static bool IsDone(const JobHandle& job);
+
         // Stats
         static uint32_t GetThreadCount();
         static uint32_t GetWorkingThreadCount();
@@ -0,0 +1,400 @@
+/*
+Copyright(c) 2016-2023 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+//= INCLUDES ==========
+#include "pch.h"
+#include "AssetFile.h"
+#include "FileStream.h"
+SP_WARNINGS_OFF
+#include "../Rendering/meshoptimizer/meshoptimizer.h"
+SP_WARNINGS_ON
+//=====================
+
+//= NAMESPACES =====
+using namespace std;
+//==================
+
+namespace Spartan
+{
+    namespace
+    {
+        const uint32_t magic       = 0x46415053; // "SPAF"
+        const uint32_t header_size = 16;        // magic, version, alignment, reserved
+        const uint32_t footer_size = 16;        // table of contents offset, chunk count, magic
+        const uint32_t toc_entry_size_v1 = 32;  // type, index, offset, size, checksum, flags
+        const uint32_t toc_entry_size    = 44;  // type, index, offset, size, uncompressed size, checksum, compression, stride
+
+        // fnv-1a over 64-bit words, fast enough to verify every chunk on load and good enough to catch corruption
+        uint32_t compute_checksum(const std::byte* data, const uint64_t size)
+        {
+            const uint64_t prime = 0x100000001b3;
+            uint64_t hash        = 0xcbf29ce484222325;
+
+            uint64_t i = 0;
+            for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t))
+            {
+                uint64_t word;
+                memcpy(&word, data + i, sizeof(uint64_t));
+                hash = (hash ^ word) * prime;
+            }
+
+            for (; i < size; i++)
+            {
+                hash = (hash ^ static_cast<uint64_t>(data[i])) * prime;
+            }
+
+            return static_cast<uint32_t>(hash ^ (hash >> 32));
+        }
+
+        uint64_t align(const uint64_t offset)
+        {
+            return (offset + asset_chunk_alignment - 1) & ~static_cast<uint64_t>(asset_chunk_alignment - 1);
+        }
+
+        atomic<bool> compression_enabled = true;
+
+        // returns false if the data doesn't meet the codec's requirements or doesn't get smaller
+        bool compress(const AssetCompression compression, const uint32_t stride, const void* data, const uint64_t size, vector<unsigned char>* compressed)
+        {
+            if (compression == AssetCompression::Vertex)
+            {
+                if (stride == 0 || stride % 4 != 0 || stride > 256 || size % stride != 0)
+                    return false;
+
+                const size_t vertex_count = static_cast<size_t>(size / stride);
+                compressed->resize(meshopt_encodeVertexBufferBound(vertex_count, stride));
+                compressed->resize(meshopt_encodeVertexBuffer(compressed->data(), compressed->size(), data, vertex_count, stride));
+            }
+            else if (compression == AssetCompression::Index)
+            {
+                if (size % (sizeof(uint32_t) * 3) != 0)
+                    return false;
+
+                const uint32_t* indices  = static_cast<const uint32_t*>(data);
+                const size_t index_count = static_cast<size_t>(size / sizeof(uint32_t));
+                const size_t vertex_count = index_count == 0 ? 0 : static_cast<size_t>(*max_element(indices, indices + index_count)) + 1;
+                compressed->resize(meshopt_encodeIndexBufferBound(index_count, vertex_count));
+                compressed->resize(meshopt_encodeIndexBuffer(compressed->data(), compressed->size(), indices, index_count));
+            }
+            else
+            {
+                return false;
+            }
+
+            return !compressed->empty() && compressed->size() < size;
+        }
+
+        bool decompress(const AssetChunkInfo& chunk, const std::byte* data, void* destination)
+        {
+            const unsigned char* buffer = reinterpret_cast<const unsigned char*>(data);
+
+            switch (chunk.compression)
+            {
+            case AssetCompression::None:
+                memcpy(destination, data, chunk.size);
+                return true;
+            case AssetCompression::Vertex:
+                return chunk.stride != 0 && meshopt_decodeVertexBuffer(destination, chunk.size_uncompressed / chunk.stride, chunk.stride, buffer, chunk.size) == 0;
+            case AssetCompression::Index:
+                return meshopt_decodeIndexBuffer(destination, chunk.size_uncompressed / sizeof(uint32_t), sizeof(uint32_t), buffer, chunk.size) == 0;
+            default:
+                return false;
+            }
+        }
+    }
+
+    AssetFileWriter::AssetFileWriter(const string& file_path, const uint32_t stream_flags)
+    {
+        m_file = make_unique<FileStream>(file_path, FileStream_Write | FileStream_Buffered | stream_flags);
+        if (!m_file->IsOpen())
+        {
+            m_file = nullptr;
+            return;
+        }
+
+        m_file->Write(magic);
+        m_file->Write(asset_file_version);
+        m_file->Write(asset_chunk_alignment);
+        m_file->Write(static_cast<uint32_t>(0));
+        m_offset = header_size;
+    }
+
+    AssetFileWriter::~AssetFileWriter()
+    {
+        Close();
+    }
+
+    void AssetFileWriter::AddChunk(const AssetChunkType type, const uint32_t index, const void* data, const uint64_t size, const AssetCompression compression, const uint32_t stride)
+    {
+        AssetChunkInfo chunk;
+        chunk.type              = type;
+        chunk.index             = index;
+        chunk.size_uncompressed = size;
+
+        vector<unsigned char> compressed;
+        if (compression_enabled && compress(compression, stride, data, size, &compressed))
+        {
+            chunk.compression = compression;
+            chunk.stride      = stride;
+            chunk.size        = compressed.size();
+            CopyChunk(chunk, span<const std::byte>(reinterpret_cast<const std::byte*>(compressed.data()), compressed.size()));
+        }
+        else
+        {
+            chunk.size = size;
+            CopyChunk(chunk, span<const std::byte>(static_cast<const std::byte*>(data), size));
+        }
+    }
+
+    void AssetFileWriter::CopyChunk(const AssetChunkInfo& chunk, span<const std::byte> data_stored)
+    {
+        SP_ASSERT_MSG(IsOpen(), "The file is not open");
+        SP_ASSERT_MSG(chunk.size == data_stored.size(), "The chunk size doesn't match the data");
+
+        // pad up to the alignment
+        const uint64_t offset = align(m_offset);
+        const array<std::byte, asset_chunk_alignment> padding = {};
+        m_file->WriteBytes(padding.data(), offset - m_offset);
+
+        AssetChunkInfo& chunk_written = m_chunks.emplace_back(chunk);
+        chunk_written.offset          = offset;
+        chunk_written.checksum        = compute_checksum(data_stored.data(), data_stored.size());
+
+        m_file->WriteBytes(data_stored.data(), data_stored.size());
+        m_offset             = offset + data_stored.size();
+        m_size              += data_stored.size();
+        m_size_uncompressed += chunk.size_uncompressed;
+    }
+
+    void AssetFileWriter::SetCompressionEnabled(const bool enabled)
+    {
+        compression_enabled = enabled;
+    }
+
+    bool AssetFileWriter::GetCompressionEnabled()
+    {
+        return compression_enabled;
+    }
+
+    bool AssetFileWriter::Close()
+    {
+        if (!m_file)
+            return false;
+
+        // table of contents
+        const uint64_t toc_offset = m_offset;
+        for (const AssetChunkInfo& chunk : m_chunks)
+        {
+            m_file->Write(static_cast<uint32_t>(chunk.type));
+            m_file->Write(chunk.index);
+            m_file->Write(chunk.offset);
+            m_file->Write(chunk.size);
+            m_file->Write(chunk.size_uncompressed);
+            m_file->Write(chunk.checksum);
+            m_file->Write(static_cast<uint32_t>(chunk.compression));
+            m_file->Write(chunk.stride);
+        }
+
+        // footer
+        m_file->Write(toc_offset);
+        m_file->Write(static_cast<uint32_t>(m_chunks.size()));
+        m_file->Write(magic);
+
+        m_file->Close();
+        m_file = nullptr;
+
+        return true;
+    }
+
+    AssetFileReader::AssetFileReader(const string& file_path)
+    {
+        m_file_path = file_path;
+        m_file      = make_unique<FileStream>(file_path, FileStream_Read | FileStream_Mapped);
+        if (!m_file->IsOpen())
+        {
+            m_file = nullptr;
+            return;
+        }
+
+        // files which were written before the container existed don't start with the magic, which is not an error
+        const uint64_t file_size = m_file->GetSize();
+        if (file_size < header_size + footer_size || m_file->ReadAs<uint32_t>() != magic)
+        {
+            m_file = nullptr;
+            return;
+        }
+
+        m_version = m_file->ReadAs<uint32_t>();
+        if (m_version > asset_file_version)
+        {
+            SP_LOG_ERROR("\"%s\" was written by a newer version (%d) of the engine", file_path.c_str(), m_version);
+            m_file = nullptr;
+            return;
+        }
+
+        // footer
+        m_file->Seek(file_size - footer_size);
+        const uint64_t toc_offset  = m_file->ReadAs<uint64_t>();
+        const uint32_t chunk_count = m_file->ReadAs<uint32_t>();
+        // the table of contents has to fit between the header and the footer, checked before anything is allocated for it
+        const uint64_t toc_size_max = file_size - footer_size;
+        const uint64_t toc_size     = static_cast<uint64_t>(chunk_count) * (m_version >= 2 ? toc_entry_size : toc_entry_size_v1);
+        if (m_file->ReadAs<uint32_t>() != magic || toc_offset < header_size || toc_offset > toc_size_max || toc_size > toc_size_max - toc_offset)
+        {
+            SP_LOG_ERROR("\"%s\" is truncated or corrupt", file_path.c_str());
+            m_file = nullptr;
+            return;
+        }
+
+        // table of contents
+        m_file->Seek(toc_offset);
+        m_chunks.resize(chunk_count);
+        for (AssetChunkInfo& chunk : m_chunks)
+        {
+            chunk.type     = static_cast<AssetChunkType>(m_file->ReadAs<uint32_t>());
+            chunk.index    = m_file->ReadAs<uint32_t>();
+            chunk.offset = m_file->ReadAs<uint64_t>();
+            chunk.size   = m_file->ReadAs<uint64_t>();
+
+            if (m_version >= 2)
+            {
+                chunk.size_uncompressed = m_file->ReadAs<uint64_t>();
+                chunk.checksum          = m_file->ReadAs<uint32_t>();
+                chunk.compression       = static_cast<AssetCompression>(m_file->ReadAs<uint32_t>());
+                chunk.stride            = m_file->ReadAs<uint32_t>();
+            }
+            else
+            {
+                chunk.size_uncompressed = chunk.size;
+                chunk.checksum          = m_file->ReadAs<uint32_t>();
+                m_file->ReadAs<uint32_t>(); // flags, unused
+            }
+
+            // written this way so that offset + size can't overflow
+            if (chunk.offset < header_size || chunk.offset > toc_offset || chunk.size > toc_offset - chunk.offset)
+            {
+                SP_LOG_ERROR("\"%s\" has a chunk which is out of bounds", file_path.c_str());
+                m_chunks.clear();
+                m_file = nullptr;
+                return;
+            }
+
+            // the table of contents isn't checksummed, and reads of stored chunks copy size bytes into a buffer of size_uncompressed
+            if (chunk.compression == AssetCompression::None && chunk.size != chunk.size_uncompressed)
+            {
+                SP_LOG_ERROR("\"%s\" has a chunk with an inconsistent size", file_path.c_str());
+                m_chunks.clear();
+                m_file = nullptr;
+                return;
+            }
+        }
+
+        // a view of the whole file, so that chunks can be accessed without moving the stream's cursor
+        m_file->Seek(0);
+        m_data = m_file->ReadView(file_size);
+    }
+
+    AssetFileReader::~AssetFileReader() = default;
+
+    const AssetChunkInfo* AssetFileReader::FindChunk(const AssetChunkType type, const uint32_t index) const
+    {
+        for (const AssetChunkInfo& chunk : m_chunks)
+        {
+            if (chunk.type == type && chunk.index == index)
+                return &chunk;
+        }
+
+        return nullptr;
+    }
+
+    bool AssetFileReader::GetChunk(const AssetChunkType type, const uint32_t index, span<const std::byte>* data_stored) const
+    {
+        const AssetChunkInfo* chunk = FindChunk(type, index);
+        return chunk && GetChunk(*chunk, data_stored);
+    }
+
+    bool AssetFileReader::GetChunk(const AssetChunkInfo& chunk, span<const std::byte>* data_stored) const
+    {
+        *data_stored = m_data.subspan(chunk.offset, chunk.size);
+
+        if (compute_checksum(data_stored->data(), data_stored->size()) != chunk.checksum)
+        {
+            SP_LOG_ERROR("Chunk %d:%d of \"%s\" is corrupt", static_cast<uint32_t>(chunk.type), chunk.index, m_file_path.c_str());
+            *data_stored = {};
+            return false;
+        }
+
+        return true;
+    }
+
+    bool AssetFileReader::Read(const AssetChunkType type, const uint32_t index, string* value) const
+    {
+        const AssetChunkInfo* chunk = FindChunk(type, index);
+        if (!chunk)
+            return false;
+
+        value->resize(chunk->size_uncompressed);
+        return Read(*chunk, value->data(), value->size());
+    }
+
+    bool AssetFileReader::Read(const AssetChunkType type, const uint32_t index, void* destination, const uint64_t size) const
+    {
+        const AssetChunkInfo* chunk = FindChunk(type, index);
+        return chunk && Read(*chunk, destination, size);
+    }
+
+    bool AssetFileReader::Read(const AssetChunkInfo& chunk, void* destination, const uint64_t size) const
+    {
+        span<const std::byte> data_stored;
+        if (chunk.size_uncompressed != size || !GetChunk(chunk, &data_stored))
+            return false;
+
+        if (!decompress(chunk, data_stored.data(), destination))
+        {
+            SP_LOG_ERROR("Failed to decompress chunk %d:%d of \"%s\"", static_cast<uint32_t>(chunk.type), chunk.index, m_file_path.c_str());
+            return false;
+        }
+
+        return true;
+    }
+
+    uint64_t AssetFileReader::GetSize() const
+    {
+        uint64_t size = 0;
+        for (const AssetChunkInfo& chunk : m_chunks)
+        {
+            size += chunk.size;
+        }
+
+        return size;
+    }
+
+    uint64_t AssetFileReader::GetSizeUncompressed() const
+    {
+        uint64_t size = 0;
+        for (const AssetChunkInfo& chunk : m_chunks)
+        {
+            size += chunk.size_uncompressed;
+        }
+
+        return size;
+    }
+}
@@ -0,0 +1,166 @@
+/*
+Copyright(c) 2016-2023 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+//= INCLUDES =
+#include <span>
+#include <memory>
+#include <string>
+#include <vector>
+//============
+
+namespace Spartan
+{
+    class FileStream;
+
+    // Native assets are stored as a container of chunks:
+    // [header][chunk 0][chunk 1]...[chunk n][table of contents][footer]
+    // Chunks start at an aligned offset so that they can be used in place when the file is memory mapped, each one
+    // carries a checksum, and the table of contents allows any chunk (e.g. a single mip or submesh) to be read on its own.
+    // The table of contents is at the end so that the file can be written sequentially, through a buffered stream.
+
+    const uint32_t asset_file_version    = 2; // 2: per chunk compression
+    const uint32_t asset_chunk_alignment = 16;
+
+    enum class AssetChunkType : uint32_t
+    {
+        Path,       // the resource file path, as a string
+        Properties, // fixed size properties of the resource
+        Submeshes,  // submesh table, indices and vertices are stored per submesh
+        Indices,
+        Vertices,
+        Mip,        // index is slice_index * mip_count + mip_index
+        Resources,  // resource list, index 0 holds the types and index i + 1 the path of resource i
+        Entity,     // world snapshot, one entity per chunk in depth first order, so parents precede their children
+        Lods,       // lod table, lod_count - 1 entries per submesh
+        LodIndices  // the indices of all the lods, stored after the mesh's indices
+    };
+
+    // Compression is a hint, chunks which don't meet the codec's requirements or don't get smaller are stored as they are
+    enum class AssetCompression : uint32_t
+    {
+        None,
+        Vertex, // meshoptimizer's vertex codec, the stride is the element size (a multiple of 4, up to 256), also works well for pixels
+        Index   // meshoptimizer's index codec, for triangle lists of 32-bit indices, triangles may be rotated but keep their winding
+    };
+
+    struct AssetChunkInfo
+    {
+        AssetChunkType type           = AssetChunkType::Path;
+        uint32_t index                = 0;
+        uint64_t offset               = 0;
+        uint64_t size                 = 0; // as stored
+        uint64_t size_uncompressed    = 0;
+        uint32_t checksum             = 0; // of the stored bytes
+        AssetCompression compression  = AssetCompression::None;
+        uint32_t stride               = 0;
+    };
+
+    class SP_CLASS AssetFileWriter
+    {
+    public:
+        // stream_flags are added to the stream's, e.g. FileStream_AsyncFlush for big files written while the engine runs
+        AssetFileWriter(const std::string& file_path, uint32_t stream_flags = 0);
+        ~AssetFileWriter();
+
+        bool IsOpen() const { return m_file != nullptr; }
+
+        void AddChunk(AssetChunkType type, uint32_t index, const void* data, uint64_t size, AssetCompression compression = AssetCompression::None, uint32_t stride = 0);
+        void AddChunk(AssetChunkType type, uint32_t index, std::span<const std::byte> data) { AddChunk(type, index, data.data(), data.size()); }
+        void AddChunk(AssetChunkType type, uint32_t index, const std::string& value)        { AddChunk(type, index, value.data(), value.size()); }
+        template <class T>
+        void AddChunk(AssetChunkType type, uint32_t index, const std::vector<T>& values)
+        {
+            static_assert(std::is_trivially_copyable_v<T>, "Chunks can only hold trivially copyable data");
+            AddChunk(type, index, values.data(), values.size() * sizeof(T));
+        }
+
+        // copies a chunk from another file as it's stored, without decompressing it
+        void CopyChunk(const AssetChunkInfo& chunk, std::span<const std::byte> data_stored);
+
+        // of all the chunks, as stored and uncompressed
+        uint64_t GetSize() const             { return m_size; }
+        uint64_t GetSizeUncompressed() const { return m_size_uncompressed; }
+
+        // compression can be turned off globally, e.g. for faster iteration while importing
+        static void SetCompressionEnabled(bool enabled);
+        static bool GetCompressionEnabled();
+
+        // writes the table of contents, the file is incomplete until this is called (the destructor calls it as well)
+        bool Close();
+
+    private:
+        std::unique_ptr<FileStream> m_file;
+        std::vector<AssetChunkInfo> m_chunks;
+        uint64_t m_offset            = 0;
+        uint64_t m_size              = 0;
+        uint64_t m_size_uncompressed = 0;
+    };
+
+    class SP_CLASS AssetFileReader
+    {
+    public:
+        AssetFileReader(const std::string& file_path);
+        ~AssetFileReader();
+
+        // false if the file doesn't exist or isn't a container (e.g. a file written before the container existed)
+        bool IsOpen() const { return m_file != nullptr; }
+        uint32_t GetVersion() const { return m_version; }
+        const std::vector<AssetChunkInfo>& GetChunks() const { return m_chunks; }
+        const AssetChunkInfo* FindChunk(AssetChunkType type, uint32_t index = 0) const;
+        bool HasChunk(AssetChunkType type, uint32_t index = 0) const { return FindChunk(type, index) != nullptr; }
+
+        // The view holds the bytes as they are stored (possibly compressed) and points into the mapped file, it's valid
+        // for as long as the reader is. False if the chunk is missing or its checksum doesn't match. Chunks are only
+        // guaranteed to be aligned to asset_chunk_alignment.
+        bool GetChunk(AssetChunkType type, uint32_t index, std::span<const std::byte>* data_stored) const;
+        bool GetChunk(const AssetChunkInfo& chunk, std::span<const std::byte>* data_stored) const; // chunk from GetChunks(), skips the lookup
+
+        // Reading decompresses, these are thread safe so that chunks can be decompressed in parallel
+        bool Read(AssetChunkType type, uint32_t index, std::string* value) const;
+        bool Read(AssetChunkType type, uint32_t index, void* destination, uint64_t size) const;
+        bool Read(const AssetChunkInfo& chunk, void* destination, uint64_t size) const;
+        template <class T>
+        bool Read(AssetChunkType type, uint32_t index, std::vector<T>* values) const
+        {
+            static_assert(std::is_trivially_copyable_v<T>, "Chunks can only hold trivially copyable data");
+
+            const AssetChunkInfo* chunk = FindChunk(type, index);
+            if (!chunk)
+                return false;
+
+            values->resize(chunk->size_uncompressed / sizeof(T));
+            return Read(type, index, values->data(), values->size() * sizeof(T));
+        }
+
+        // of all the chunks, as stored and uncompressed
+        uint64_t GetSize() const;
+        uint64_t GetSizeUncompressed() const;
+
+    private:
+        std::unique_ptr<FileStream> m_file;
+        std::vector<AssetChunkInfo> m_chunks;
+        std::span<const std::byte> m_data; // the whole file
+        std::string m_file_path;
+        uint32_t m_version = 0;
+    };
+}
@@ -25,12 +25,26 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "../RHI/RHI_Vertex.h"
 //============================
 
+#if defined(_MSC_VER)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
 //= NAMESPACES =====
 using namespace std;
 //==================
 
 namespace Spartan
 {
+    namespace
+    {
+        const uint64_t write_buffer_size = 4 * 1024 * 1024;
+    }
+
     FileStream::FileStream(const string& path, uint32_t flags)
     {
         m_is_open = false;
@@ -49,6 +63,21 @@ namespace Spartan
                 SP_LOG_ERROR("Failed to open \"%s\" for writing", path.c_str());
                 return;
             }
+
+            if (m_flags & FileStream_AsyncFlush)
+            {
+                m_flags |= FileStream_Buffered;
+                m_write_thread = thread(&FileStream::WriteThread, this);
+            }
+
+            if (m_flags & FileStream_Buffered)
+            {
+                m_write_buffer.reserve(write_buffer_size);
+            }
+        }
+        else if ((m_flags & FileStream_Read) && (m_flags & FileStream_Mapped) && Map(path))
+        {
+            // reads go through the mapping
         }
         else if (m_flags & FileStream_Read)
         {
@@ -63,6 +92,22 @@ namespace Spartan
         m_is_open = true;
     }
 
+    FileStream::FileStream(span<const std::byte> data)
+    {
+        m_flags         = FileStream_Read | FileStream_Mapped | FileStream_Memory;
+        m_mapped_data   = data.data();
+        m_mapped_size   = data.size();
+        m_mapped_offset = 0;
+        m_is_open       = true;
+    }
+
+    FileStream::FileStream(vector<std::byte>* data)
+    {
+        m_flags      = FileStream_Write | FileStream_Memory;
+        m_memory_out = data;
+        m_is_open    = data != nullptr;
+    }
+
     FileStream::~FileStream()
     {
         Close();
@@ -72,22 +117,292 @@ namespace Spartan
     {
         if (m_flags & FileStream_Write)
         {
-            out.flush();
+            Flush();
+
+            if (m_write_thread.joinable())
+            {
+                {
+                    lock_guard<mutex> lock(m_write_mutex);
+                    m_write_thread_stop = true;
+                }
+                m_write_condition.notify_all();
+                m_write_thread.join();
+            }
+
             out.close();
         }
         else if (m_flags & FileStream_Read)
         {
+            Unmap();
             in.clear();
             in.close();
         }
     }
 
+    void FileStream::Flush()
+    {
+        if (!(m_flags & FileStream_Write) || (m_flags & FileStream_Memory))
+            return;
+
+        SubmitWriteBuffer();
+
+        if (m_write_thread.joinable())
+        {
+            unique_lock<mutex> lock(m_write_mutex);
+            m_write_condition.wait(lock, [this]() { return m_write_queue.empty() && !m_write_thread_busy; });
+        }
+
+        out.flush();
+    }
+
+    void FileStream::WriteBytes(const void* source, const uint64_t size)
+    {
+        if (m_memory_out)
+        {
+            const std::byte* bytes = static_cast<const std::byte*>(source);
+            m_memory_out->insert(m_memory_out->end(), bytes, bytes + size);
+            return;
+        }
+
+        if (!(m_flags & FileStream_Buffered))
+        {
+            out.write(reinterpret_cast<const char*>(source), size);
+            return;
+        }
+
+        if (m_write_buffer.size() + size > write_buffer_size)
+        {
+            SubmitWriteBuffer();
+        }
+
+        // payloads which don't fit in a buffer (e.g. texture mips) are written as they are, after what's buffered
+        if (size > write_buffer_size && !m_write_thread.joinable())
+        {
+            out.write(reinterpret_cast<const char*>(source), size);
+            return;
+        }
+
+        const std::byte* bytes = static_cast<const std::byte*>(source);
+        m_write_buffer.insert(m_write_buffer.end(), bytes, bytes + size);
+    }
+
+    void FileStream::SubmitWriteBuffer()
+    {
+        if (m_write_buffer.empty())
+            return;
+
+        if (!m_write_thread.joinable())
+        {
+            out.write(reinterpret_cast<const char*>(m_write_buffer.data()), m_write_buffer.size());
+            m_write_buffer.clear();
+            return;
+        }
+
+        // hand the buffer over to the write thread and continue with a recycled one
+        {
+            lock_guard<mutex> lock(m_write_mutex);
+            m_write_queue.emplace_back(move(m_write_buffer));
+
+            if (!m_write_buffers_free.empty())
+            {
+                m_write_buffer = move(m_write_buffers_free.back());
+                m_write_buffers_free.pop_back();
+            }
+            else
+            {
+                m_write_buffer = vector<std::byte>();
+                m_write_buffer.reserve(write_buffer_size);
+            }
+        }
+        m_write_condition.notify_all();
+    }
+
+    void FileStream::WriteThread()
+    {
+        unique_lock<mutex> lock(m_write_mutex);
+
+        while (true)
+        {
+            m_write_condition.wait(lock, [this]() { return !m_write_queue.empty() || m_write_thread_stop; });
+
+            if (m_write_queue.empty())
+                return;
+
+            // take everything that's queued and write it out in one go, outside of the lock
+            deque<vector<std::byte>> buffers = move(m_write_queue);
+            m_write_queue.clear();
+            m_write_thread_busy = true;
+            lock.unlock();
+
+            for (const vector<std::byte>& buffer : buffers)
+            {
+                out.write(reinterpret_cast<const char*>(buffer.data()), buffer.size());
+            }
+
+            lock.lock();
+            m_write_thread_busy = false;
+            for (vector<std::byte>& buffer : buffers)
+            {
+                // oversized buffers (from large payloads) are not worth keeping around
+                if (buffer.capacity() <= write_buffer_size)
+                {
+                    buffer.clear();
+                    m_write_buffers_free.emplace_back(move(buffer));
+                }
+            }
+            m_write_condition.notify_all();
+        }
+    }
+
+    bool FileStream::Map(const string& path)
+    {
+        // an empty file can't be mapped, the caller falls back to regular reads
+        #if defined(_MSC_VER)
+            HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+            if (file == INVALID_HANDLE_VALUE)
+                return false;
+
+            LARGE_INTEGER size = {};
+            if (!GetFileSizeEx(file, &size) || size.QuadPart == 0)
+            {
+                CloseHandle(file);
+                return false;
+            }
+
+            HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            void* data     = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+
+            // the view keeps the mapping alive
+            if (mapping)
+            {
+                CloseHandle(mapping);
+            }
+            CloseHandle(file);
+
+            if (!data)
+                return false;
+
+            m_mapped_size = static_cast<uint64_t>(size.QuadPart);
+        #else
+            int file = open(path.c_str(), O_RDONLY);
+            if (file == -1)
+                return false;
+
+            struct stat info = {};
+            if (fstat(file, &info) != 0 || info.st_size == 0)
+            {
+                close(file);
+                return false;
+            }
+
+            void* data = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+
+            // the mapping outlives the descriptor
+            close(file);
+
+            if (data == MAP_FAILED)
+                return false;
+
+            madvise(data, static_cast<size_t>(info.st_size), MADV_SEQUENTIAL);
+            m_mapped_size = static_cast<uint64_t>(info.st_size);
+        #endif
+
+        m_mapped_data   = static_cast<const std::byte*>(data);
+        m_mapped_offset = 0;
+
+        return true;
+    }
+
+    void FileStream::Unmap()
+    {
+        if (!m_mapped_data)
+            return;
+
+        // memory streams don't own what they read from
+        if (!(m_flags & FileStream_Memory))
+        {
+            #if defined(_MSC_VER)
+                UnmapViewOfFile(m_mapped_data);
+            #else
+                munmap(const_cast<std::byte*>(m_mapped_data), static_cast<size_t>(m_mapped_size));
+            #endif
+        }
+
+        m_mapped_data   = nullptr;
+        m_mapped_size   = 0;
+        m_mapped_offset = 0;
+    }
+
+    void FileStream::ReadBytes(void* destination, const uint64_t size)
+    {
+        if (!m_mapped_data && !(m_flags & FileStream_Memory))
+        {
+            in.read(reinterpret_cast<char*>(destination), size);
+            return;
+        }
+
+        // reading past the end yields zeros, instead of going past the mapping
+        const uint64_t available = min(size, m_mapped_size - m_mapped_offset);
+        if (available > 0)
+        {
+            memcpy(destination, m_mapped_data + m_mapped_offset, available);
+        }
+        if (available < size)
+        {
+            memset(static_cast<std::byte*>(destination) + available, 0, size - available);
+        }
+
+        m_mapped_offset += available;
+    }
+
+    void FileStream::Seek(const uint64_t offset)
+    {
+        if (m_mapped_data || (m_flags & FileStream_Memory))
+        {
+            m_mapped_offset = min(offset, m_mapped_size);
+        }
+        else
+        {
+            in.clear();
+            in.seekg(offset, ios::beg);
+        }
+    }
+
+    uint64_t FileStream::GetSize()
+    {
+        if (m_mapped_data || (m_flags & FileStream_Memory))
+            return m_mapped_size;
+
+        const streampos position = in.tellg();
+        in.seekg(0, ios::end);
+        const streampos size = in.tellg();
+        in.seekg(position, ios::beg);
+
+        return size < 0 ? 0 : static_cast<uint64_t>(size);
+    }
+
+    span<const std::byte> FileStream::ReadView(const uint64_t size)
+    {
+        if (!m_mapped_data && !(m_flags & FileStream_Memory))
+        {
+            m_view_buffer.resize(size);
+            in.read(reinterpret_cast<char*>(m_view_buffer.data()), size);
+            return span<const std::byte>(m_view_buffer.data(), m_view_buffer.size());
+        }
+
+        const uint64_t available = min(size, m_mapped_size - m_mapped_offset);
+        span<const std::byte> view(m_mapped_data + m_mapped_offset, available);
+        m_mapped_offset += available;
+
+        return view;
+    }
+
     void FileStream::Write(const string& value)
     {
         const auto length = static_cast<uint32_t>(value.length());
         Write(length);
 
-        out.write(const_cast<char*>(value.c_str()), length);
+        WriteBytes(value.data(), length);
     }
 
     void FileStream::Write(const vector<string>& value)
@@ -105,42 +420,52 @@ namespace Spartan
     {
         const auto length = static_cast<uint32_t>(value.size());
         Write(length);
-        out.write(reinterpret_cast<const char*>(&value[0]), sizeof(RHI_Vertex_PosTexNorTan) * length);
+        WriteBytes(value.data(), sizeof(RHI_Vertex_PosTexNorTan) * length);
     }
 
     void FileStream::Write(const vector<uint32_t>& value)
     {
         const auto length = static_cast<uint32_t>(value.size());
         Write(length);
-        out.write(reinterpret_cast<const char*>(&value[0]), sizeof(uint32_t) * length);
+        WriteBytes(value.data(), sizeof(uint32_t) * length);
     }
 
     void FileStream::Write(const vector<unsigned char>& value)
     {
         const auto size = static_cast<uint32_t>(value.size());
         Write(size);
-        out.write(reinterpret_cast<const char*>(&value[0]), sizeof(unsigned char) * size);
+        WriteBytes(value.data(), sizeof(unsigned char) * size);
     }
 
     void FileStream::Write(const vector<byte>& value)
     {
         const auto size = static_cast<uint32_t>(value.size());
         Write(size);
-        out.write(reinterpret_cast<const char*>(&value[0]), sizeof(std::byte) * size);
+        WriteBytes(value.data(), sizeof(std::byte) * size);
     }
 
     void FileStream::Write(const atomic<bool>& value)
     {
-        out.write(reinterpret_cast<const char*>(&value), sizeof(bool));
+        WriteBytes(&value, sizeof(bool));
     }
 
     void FileStream::Skip(uint64_t n)
     {
         // Set the seek cursor to offset n from the current position
-        if (m_flags & FileStream_Write)
+        if (m_memory_out)
         {
+            m_memory_out->resize(m_memory_out->size() + n);
+        }
+        else if (m_flags & FileStream_Write)
+        {
+            // the buffered bytes have to land before the cursor can move
+            Flush();
             out.seekp(n, ios::cur);
         }
+        else if (m_mapped_data)
+        {
+            m_mapped_offset = min(m_mapped_offset + n, m_mapped_size);
+        }
         else if (m_flags & FileStream_Read)
         {
             in.ignore(n, ios::cur);
@@ -153,7 +478,7 @@ namespace Spartan
         Read(&length);
 
         value->resize(length);
-        in.read(const_cast<char*>(value->c_str()), length);
+        ReadBytes(value->data(), length);
     }
 
     void FileStream::Read(vector<string>* vec)
@@ -186,7 +511,7 @@ namespace Spartan
         vec->reserve(length);
         vec->resize(length);
 
-        in.read(reinterpret_cast<char*>(vec->data()), sizeof(RHI_Vertex_PosTexNorTan) * length);
+        ReadBytes(vec->data(), sizeof(RHI_Vertex_PosTexNorTan) * length);
     }
 
     void FileStream::Read(vector<uint32_t>* vec)
@@ -201,7 +526,7 @@ namespace Spartan
         vec->reserve(length);
         vec->resize(length);
 
-        in.read(reinterpret_cast<char*>(vec->data()), sizeof(uint32_t) * length);
+        ReadBytes(vec->data(), sizeof(uint32_t) * length);
     }
 
     void FileStream::Read(vector<unsigned char>* vec)
@@ -216,7 +541,7 @@ namespace Spartan
         vec->reserve(length);
         vec->resize(length);
 
-        in.read(reinterpret_cast<char*>(vec->data()), sizeof(unsigned char) * length);
+        ReadBytes(vec->data(), sizeof(unsigned char) * length);
     }
 
     void FileStream::Read(vector<std::byte>* vec)
@@ -231,11 +556,11 @@ namespace Spartan
         vec->reserve(length);
         vec->resize(length);
 
-        in.read(reinterpret_cast<char*>(vec->data()), sizeof(std::byte) * length);
+        ReadBytes(vec->data(), sizeof(std::byte) * length);
     }
 
     void FileStream::Read(std::atomic<bool>* value)
     {
-        in.read(reinterpret_cast<char*>(value), sizeof(bool));
+        ReadBytes(value, sizeof(bool));
     }
 }
@@ -22,8 +22,13 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #pragma once
 
 //= INCLUDES ===================
+#include <span>
+#include <mutex>
+#include <deque>
+#include <thread>
 #include <vector>
 #include <fstream>
+#include <condition_variable>
 #include "../Math/Vector2.h"
 #include "../Math/Vector3.h"
 #include "../Math/Vector4.h"
@@ -39,15 +44,24 @@ namespace Spartan
         FileStream_Read   = 1 << 0,
         FileStream_Write  = 1 << 1,
         FileStream_Append = 1 << 2,
+        FileStream_Mapped = 1 << 3, // read through a memory mapping of the file, which also enables zero-copy views
+        FileStream_Buffered   = 1 << 4, // gather writes in a large buffer and write it out in big blocks
+        FileStream_AsyncFlush = 1 << 5, // buffered, plus full buffers are written out by a background thread
+        FileStream_Memory     = 1 << 6  // reads from, or appends to, memory owned by the caller (set by the memory constructors)
     };
 
     class SP_CLASS FileStream
     {
     public:
         FileStream(const std::string& path, uint32_t flags);
+        // Memory streams, so that serialization can run on many threads at once, each with its own stream,
+        // e.g. reading from a chunk of a mapped asset file, or writing into a blob which becomes a chunk.
+        FileStream(std::span<const std::byte> data);
+        FileStream(std::vector<std::byte>* data);
         ~FileStream();
 
         auto IsOpen() const { return m_is_open; }
+        void Flush(); // blocks until everything written so far has reached the file
         void Close();
 
         //= WRITING ==================================================
@@ -76,7 +90,7 @@ namespace Spartan
         >::type>
         void Write(T value)
         {
-            out.write(reinterpret_cast<char*>(&value), sizeof(value));
+            WriteBytes(&value, sizeof(value));
         }
 
         void Write(const std::string& value);
@@ -86,6 +100,7 @@ namespace Spartan
         void Write(const std::vector<unsigned char>& value);
         void Write(const std::vector<std::byte>& value);
         void Write(const std::atomic<bool>& value);
+        void WriteBytes(const void* source, uint64_t size); // raw, without a size prefix
         void Skip(uint64_t n);
         //===========================================================
         
@@ -116,7 +131,7 @@ namespace Spartan
         >::type>
         void Read(T* value)
         {
-            in.read(reinterpret_cast<char*>(value), sizeof(T));
+            ReadBytes(value, sizeof(T));
         }
         void Read(std::string* value);
         void Read(std::vector<std::string>* vec);
@@ -125,6 +140,24 @@ namespace Spartan
         void Read(std::vector<unsigned char>* vec);
         void Read(std::vector<std::byte>* vec);
         void Read(std::atomic<bool>* value);
+        void ReadBytes(void* destination, uint64_t size); // raw, without a size prefix
+
+        // Random access reading
+        void Seek(uint64_t offset);
+        uint64_t GetSize();
+
+        // Zero-copy reading, when mapped the views point into the file and are valid until it's closed, otherwise
+        // they point to an internal buffer which is valid until the next view is read. They are raw bytes since the
+        // offsets in the file carry no alignment guarantees, so they are meant to be copied into their destination.
+        std::span<const std::byte> ReadView(uint64_t size);
+        template <class T>
+        std::span<const std::byte> ReadVectorView()
+        {
+            // reads a vector that was written with Write(const std::vector<T>&)
+            const uint64_t length = static_cast<uint64_t>(ReadAs<uint32_t>());
+            return ReadView(length * sizeof(T));
+        }
+        bool IsMapped() const { return m_mapped_data != nullptr; }
 
         // Reading with explicit type definition
         template <class T, class = typename std::enable_if
@@ -155,9 +188,33 @@ namespace Spartan
         //=====================================================
 
     private:
+        bool Map(const std::string& path);
+        void Unmap();
+        void SubmitWriteBuffer();
+        void WriteThread();
+
         std::ofstream out;
         std::ifstream in;
         uint32_t m_flags;
         bool m_is_open;
+
+        // memory mapped reading
+        const std::byte* m_mapped_data = nullptr;
+        uint64_t m_mapped_size         = 0;
+        uint64_t m_mapped_offset       = 0;
+        std::vector<std::byte> m_view_buffer;
+
+        // memory writing
+        std::vector<std::byte>* m_memory_out = nullptr;
+
+        // buffered writing
+        std::vector<std::byte> m_write_buffer;
+        std::deque<std::vector<std::byte>> m_write_queue; // full buffers, waiting for the write thread
+        std::vector<std::vector<std::byte>> m_write_buffers_free;
+        std::mutex m_write_mutex;
+        std::condition_variable m_write_condition;
+        std::thread m_write_thread;
+        bool m_write_thread_busy = false;
+        bool m_write_thread_stop = false;
     };
 }
@@ -21,6 +21,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 //= INCLUDES =======
 #include "pch.h"
+#include "Simd.h"
 //==================
 
 //= NAMESPACES =====
@@ -29,6 +30,104 @@ using namespace std;
 
 namespace Spartan::Math
 {
+    namespace
+    {
+        // The batch paths mirror IsVisible(), which is visible unless both the sphere test and the cube test say outside.
+        // The sphere test stops at the first plane that the sphere is outside of or intersects, the cube test (with the
+        // sphere's radius as its extent) is outside if it's outside of any plane. Sums are done in the same order as the
+        // scalar path, so the results agree box for box.
+
+        #if SP_SIMD_SSE
+        uint32_t is_visible_sse(const Plane* planes, const FrustumBoxes& boxes, uint64_t* visibility, const bool ignore_near_plane)
+        {
+            const __m128 sign_mask = _mm_set1_ps(-0.0f);
+            const __m128 infinity  = _mm_set1_ps(numeric_limits<float>::infinity());
+
+            const uint32_t count = boxes.count & ~3u;
+            for (uint32_t i = 0; i < count; i += 4)
+            {
+                const __m128 center_x = _mm_loadu_ps(boxes.center_x + i);
+                const __m128 center_y = _mm_loadu_ps(boxes.center_y + i);
+                const __m128 center_z = _mm_loadu_ps(boxes.center_z + i);
+                const __m128 radius   = ignore_near_plane ? infinity : _mm_max_ps(_mm_loadu_ps(boxes.extent_x + i), _mm_max_ps(_mm_loadu_ps(boxes.extent_y + i), _mm_loadu_ps(boxes.extent_z + i)));
+                const __m128 radius_n = _mm_xor_ps(radius, sign_mask);
+
+                __m128 sphere_decided = _mm_setzero_ps();
+                __m128 sphere_outside = _mm_setzero_ps();
+                __m128 cube_outside   = _mm_setzero_ps();
+                for (uint32_t plane_index = 0; plane_index < 6; plane_index++)
+                {
+                    const Plane& plane     = planes[plane_index];
+                    const __m128 normal_x  = _mm_set1_ps(plane.normal.x);
+                    const __m128 normal_y  = _mm_set1_ps(plane.normal.y);
+                    const __m128 normal_z  = _mm_set1_ps(plane.normal.z);
+                    const __m128 dot       = _mm_add_ps(_mm_add_ps(_mm_mul_ps(normal_x, center_x), _mm_mul_ps(normal_y, center_y)), _mm_mul_ps(normal_z, center_z));
+
+                    // sphere
+                    const __m128 distance   = _mm_add_ps(dot, _mm_set1_ps(plane.d));
+                    const __m128 outside    = _mm_cmplt_ps(distance, radius_n);
+                    const __m128 intersects = _mm_cmplt_ps(_mm_andnot_ps(sign_mask, distance), radius);
+                    sphere_outside          = _mm_or_ps(sphere_outside, _mm_andnot_ps(sphere_decided, outside));
+                    sphere_decided          = _mm_or_ps(sphere_decided, _mm_or_ps(outside, intersects));
+
+                    // cube
+                    const __m128 r = _mm_add_ps(_mm_add_ps(_mm_mul_ps(radius, _mm_set1_ps(Helper::Abs(plane.normal.x))), _mm_mul_ps(radius, _mm_set1_ps(Helper::Abs(plane.normal.y)))), _mm_mul_ps(radius, _mm_set1_ps(Helper::Abs(plane.normal.z))));
+                    cube_outside   = _mm_or_ps(cube_outside, _mm_cmplt_ps(_mm_add_ps(dot, r), _mm_set1_ps(-plane.d)));
+                }
+
+                const uint64_t visible = static_cast<uint64_t>(~_mm_movemask_ps(_mm_and_ps(sphere_outside, cube_outside)) & 0xF);
+                visibility[i / 64]    |= visible << (i % 64);
+            }
+
+            return count;
+        }
+
+        SP_SIMD_TARGET_AVX uint32_t is_visible_avx(const Plane* planes, const FrustumBoxes& boxes, uint64_t* visibility, const bool ignore_near_plane)
+        {
+            const __m256 sign_mask = _mm256_set1_ps(-0.0f);
+            const __m256 infinity  = _mm256_set1_ps(numeric_limits<float>::infinity());
+
+            const uint32_t count = boxes.count & ~7u;
+            for (uint32_t i = 0; i < count; i += 8)
+            {
+                const __m256 center_x = _mm256_loadu_ps(boxes.center_x + i);
+                const __m256 center_y = _mm256_loadu_ps(boxes.center_y + i);
+                const __m256 center_z = _mm256_loadu_ps(boxes.center_z + i);
+                const __m256 radius   = ignore_near_plane ? infinity : _mm256_max_ps(_mm256_loadu_ps(boxes.extent_x + i), _mm256_max_ps(_mm256_loadu_ps(boxes.extent_y + i), _mm256_loadu_ps(boxes.extent_z + i)));
+                const __m256 radius_n = _mm256_xor_ps(radius, sign_mask);
+
+                __m256 sphere_decided = _mm256_setzero_ps();
+                __m256 sphere_outside = _mm256_setzero_ps();
+                __m256 cube_outside   = _mm256_setzero_ps();
+                for (uint32_t plane_index = 0; plane_index < 6; plane_index++)
+                {
+                    const Plane& plane     = planes[plane_index];
+                    const __m256 normal_x  = _mm256_set1_ps(plane.normal.x);
+                    const __m256 normal_y  = _mm256_set1_ps(plane.normal.y);
+                    const __m256 normal_z  = _mm256_set1_ps(plane.normal.z);
+                    const __m256 dot       = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(normal_x, center_x), _mm256_mul_ps(normal_y, center_y)), _mm256_mul_ps(normal_z, center_z));
+
+                    // sphere
+                    const __m256 distance   = _mm256_add_ps(dot, _mm256_set1_ps(plane.d));
+                    const __m256 outside    = _mm256_cmp_ps(distance, radius_n, _CMP_LT_OQ);
+                    const __m256 intersects = _mm256_cmp_ps(_mm256_andnot_ps(sign_mask, distance), radius, _CMP_LT_OQ);
+                    sphere_outside          = _mm256_or_ps(sphere_outside, _mm256_andnot_ps(sphere_decided, outside));
+                    sphere_decided          = _mm256_or_ps(sphere_decided, _mm256_or_ps(outside, intersects));
+
+                    // cube
+                    const __m256 r = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(radius, _mm256_set1_ps(Helper::Abs(plane.normal.x))), _mm256_mul_ps(radius, _mm256_set1_ps(Helper::Abs(plane.normal.y)))), _mm256_mul_ps(radius, _mm256_set1_ps(Helper::Abs(plane.normal.z))));
+                    cube_outside   = _mm256_or_ps(cube_outside, _mm256_cmp_ps(_mm256_add_ps(dot, r), _mm256_set1_ps(-plane.d), _CMP_LT_OQ));
+                }
+
+                const uint64_t visible = static_cast<uint64_t>(~_mm256_movemask_ps(_mm256_and_ps(sphere_outside, cube_outside)) & 0xFF);
+                visibility[i / 64]    |= visible << (i % 64);
+            }
+
+            return count;
+        }
+        #endif
+    }
+
     Frustum::Frustum(const Matrix& view, const Matrix& projection, float screen_depth)
     {
         // Calculate the minimum Z distance in the frustum.
@@ -108,6 +207,27 @@ namespace Spartan::Math
         return false;
     }
 
+    void Frustum::IsVisible(const FrustumBoxes& boxes, uint64_t* visibility, const bool ignore_near_plane /*= false*/) const
+    {
+        memset(visibility, 0, ((boxes.count + 63) / 64) * sizeof(uint64_t));
+
+        uint32_t start = 0;
+        #if SP_SIMD_SSE
+        start = Simd::HasAvx() ? is_visible_avx(m_planes, boxes, visibility, ignore_near_plane) : is_visible_sse(m_planes, boxes, visibility, ignore_near_plane);
+        #endif
+
+        // whatever doesn't fill a register, or everything if there is no simd
+        for (uint32_t i = start; i < boxes.count; i++)
+        {
+            const Vector3 center(boxes.center_x[i], boxes.center_y[i], boxes.center_z[i]);
+            const Vector3 extent(boxes.extent_x[i], boxes.extent_y[i], boxes.extent_z[i]);
+            if (IsVisible(center, extent, ignore_near_plane))
+            {
+                visibility[i / 64] |= uint64_t(1) << (i % 64);
+            }
+        }
+    }
+
     Intersection Frustum::CheckCube(const Vector3& center, const Vector3& extent) const
     {
         Intersection result = Intersection::Inside;
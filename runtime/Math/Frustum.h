@@ -29,6 +29,18 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 namespace Spartan::Math
 {
+    // Bounding boxes as one array per component (SoA), which is the layout the batch test consumes
+    struct FrustumBoxes
+    {
+        const float* center_x = nullptr;
+        const float* center_y = nullptr;
+        const float* center_z = nullptr;
+        const float* extent_x = nullptr;
+        const float* extent_y = nullptr;
+        const float* extent_z = nullptr;
+        uint32_t count        = 0;
+    };
+
     class Frustum
     {
     public:
@@ -38,6 +50,10 @@ namespace Spartan::Math
 
         bool IsVisible(const Vector3& center, const Vector3& extent, bool ignore_near_plane = false) const;
 
+        // Tests all the boxes, 8 at a time with AVX or 4 at a time with SSE (picked at runtime), and agrees with IsVisible() on
+        // every box. Bit i of visibility is set if box i is visible, so it must hold (count + 63) / 64 words.
+        void IsVisible(const FrustumBoxes& boxes, uint64_t* visibility, bool ignore_near_plane = false) const;
+
     private:
         Intersection CheckCube(const Vector3& center, const Vector3& extent) const;
         Intersection CheckSphere(const Vector3& center, float radius) const;
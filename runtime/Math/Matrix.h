@@ -25,8 +25,12 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "Quaternion.h"
 #include "Vector3.h"
 #include "Vector4.h"
+#include "Simd.h"
 //=====================
 
+// The SIMD paths compute every element with the same operations, in the same order, as the scalar paths next
+// to them, so the two agree bit for bit (a build with SP_SIMD_DISABLED can be used to compare against).
+
 namespace Spartan::Math
 {
     class SP_CLASS Matrix
@@ -134,10 +138,19 @@ namespace Spartan::Math
 
             // Extract rotation and remove scaling
             Matrix normalized;
+        #if SP_SIMD_SSE
+            const __m128 scale_v = _mm_set_ps(1.0f, scale.z, scale.y, scale.x);
+            _mm_storeu_ps(&normalized.m00, _mm_div_ps(_mm_loadu_ps(&m00), scale_v));
+            _mm_storeu_ps(&normalized.m01, _mm_div_ps(_mm_loadu_ps(&m01), scale_v));
+            _mm_storeu_ps(&normalized.m02, _mm_div_ps(_mm_loadu_ps(&m02), scale_v));
+            normalized.m03 = 0.0f; normalized.m13 = 0.0f; normalized.m23 = 0.0f;
+            normalized.m30 = 0; normalized.m31 = 0; normalized.m32 = 0; normalized.m33 = 1.0f;
+        #else
             normalized.m00 = m00 / scale.x; normalized.m01 = m01 / scale.x; normalized.m02 = m02 / scale.x; normalized.m03 = 0.0f;
             normalized.m10 = m10 / scale.y; normalized.m11 = m11 / scale.y; normalized.m12 = m12 / scale.y; normalized.m13 = 0.0f;
             normalized.m20 = m20 / scale.z; normalized.m21 = m21 / scale.z; normalized.m22 = m22 / scale.z; normalized.m23 = 0.0f;
             normalized.m30 = 0; normalized.m31 = 0; normalized.m32 = 0; normalized.m33 = 1.0f;
+        #endif
 
             return RotationMatrixToQuaternion(normalized);
         }
@@ -200,6 +213,22 @@ namespace Spartan::Math
         //= SCALE ========================================================================================
         [[nodiscard]] Vector3 GetScale() const
         {
+        #if SP_SIMD_SSE
+            // the rows are spread across the columns, so each lane handles one row
+            const __m128 c0 = _mm_loadu_ps(&m00);
+            const __m128 c1 = _mm_loadu_ps(&m01);
+            const __m128 c2 = _mm_loadu_ps(&m02);
+            const __m128 c3 = _mm_loadu_ps(&m03);
+
+            const __m128 negative = _mm_cmplt_ps(_mm_mul_ps(_mm_mul_ps(_mm_mul_ps(c0, c1), c2), c3), _mm_setzero_ps());
+            const __m128 sign     = _mm_or_ps(_mm_set1_ps(1.0f), _mm_and_ps(negative, _mm_set1_ps(-0.0f)));
+            const __m128 length   = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(c0, c0), _mm_mul_ps(c1, c1)), _mm_mul_ps(c2, c2)));
+
+            alignas(16) float scale[4];
+            _mm_store_ps(scale, _mm_mul_ps(sign, length));
+
+            return Vector3(scale[0], scale[1], scale[2]);
+        #else
             const int xs = (Helper::Sign(m00 * m01 * m02 * m03) < 0) ? -1 : 1;
             const int ys = (Helper::Sign(m10 * m11 * m12 * m13) < 0) ? -1 : 1;
             const int zs = (Helper::Sign(m20 * m21 * m22 * m23) < 0) ? -1 : 1;
@@ -209,6 +238,7 @@ namespace Spartan::Math
                 static_cast<float>(ys) * Helper::Sqrt(m10 * m10 + m11 * m11 + m12 * m12),
                 static_cast<float>(zs) * Helper::Sqrt(m20 * m20 + m21 * m21 + m22 * m22)
             );
+        #endif
         }
 
         static inline Matrix CreateScale(float scale) { return CreateScale(scale, scale, scale); }
@@ -279,12 +309,28 @@ namespace Spartan::Math
         void Transpose() { *this = Transpose(*this); }
         static inline Matrix Transpose(const Matrix& matrix)
         {
+        #if SP_SIMD_SSE
+            __m128 c0 = _mm_loadu_ps(&matrix.m00);
+            __m128 c1 = _mm_loadu_ps(&matrix.m01);
+            __m128 c2 = _mm_loadu_ps(&matrix.m02);
+            __m128 c3 = _mm_loadu_ps(&matrix.m03);
+            _MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+
+            Matrix result;
+            _mm_storeu_ps(&result.m00, c0);
+            _mm_storeu_ps(&result.m01, c1);
+            _mm_storeu_ps(&result.m02, c2);
+            _mm_storeu_ps(&result.m03, c3);
+
+            return result;
+        #else
             return Matrix(
                 matrix.m00, matrix.m10, matrix.m20, matrix.m30,
                 matrix.m01, matrix.m11, matrix.m21, matrix.m31,
                 matrix.m02, matrix.m12, matrix.m22, matrix.m32,
                 matrix.m03, matrix.m13, matrix.m23, matrix.m33
             );
+        #endif
         }
         //==================================================================
 
@@ -292,6 +338,53 @@ namespace Spartan::Math
         [[nodiscard]] Matrix Inverted() const { return Invert(*this); }
         static inline Matrix Invert(const Matrix& matrix)
         {
+        #if SP_SIMD_SSE
+            using namespace Simd;
+
+            // rows, the scalar path below works on them
+            __m128 r0 = _mm_loadu_ps(&matrix.m00);
+            __m128 r1 = _mm_loadu_ps(&matrix.m01);
+            __m128 r2 = _mm_loadu_ps(&matrix.m02);
+            __m128 r3 = _mm_loadu_ps(&matrix.m03);
+            _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+
+            // the three sets of 2x2 determinants (v0 to v5) of the scalar path, v0-v3 in lo and v4-v5 in hi
+            const __m128 a_lo = _mm_sub_ps(_mm_mul_ps(Swizzle<0, 0, 0, 1>(r2), Swizzle<1, 2, 3, 2>(r3)), _mm_mul_ps(Swizzle<1, 2, 3, 2>(r2), Swizzle<0, 0, 0, 1>(r3)));
+            const __m128 a_hi = _mm_sub_ps(_mm_mul_ps(Swizzle<1, 2, 1, 2>(r2), Swizzle<3, 3, 3, 3>(r3)), _mm_mul_ps(Swizzle<3, 3, 3, 3>(r2), Swizzle<1, 2, 1, 2>(r3)));
+            const __m128 b_lo = _mm_sub_ps(_mm_mul_ps(Swizzle<0, 0, 0, 1>(r1), Swizzle<1, 2, 3, 2>(r3)), _mm_mul_ps(Swizzle<1, 2, 3, 2>(r1), Swizzle<0, 0, 0, 1>(r3)));
+            const __m128 b_hi = _mm_sub_ps(_mm_mul_ps(Swizzle<1, 2, 1, 2>(r1), Swizzle<3, 3, 3, 3>(r3)), _mm_mul_ps(Swizzle<3, 3, 3, 3>(r1), Swizzle<1, 2, 1, 2>(r3)));
+            const __m128 c_lo = _mm_sub_ps(_mm_mul_ps(Swizzle<1, 2, 3, 2>(r2), Swizzle<0, 0, 0, 1>(r1)), _mm_mul_ps(Swizzle<0, 0, 0, 1>(r2), Swizzle<1, 2, 3, 2>(r1)));
+            const __m128 c_hi = _mm_sub_ps(_mm_mul_ps(Swizzle<3, 3, 3, 3>(r2), Swizzle<1, 2, 1, 2>(r1)), _mm_mul_ps(Swizzle<1, 2, 1, 2>(r2), Swizzle<3, 3, 3, 3>(r1)));
+
+            // a column of the inverse, (v5, v5, v4, v3) * (r.y, r.x, r.x, r.x) - (v4, v2, v2, v1) * (r.z, r.z, r.y, r.y) + (v3, v1, v0, v0) * (r.w, r.w, r.w, r.z)
+            auto column = [](const __m128 lo, const __m128 hi, const __m128 r)
+            {
+                const __m128 v = Swizzle<1, 1, 0, 2>(_mm_shuffle_ps(hi, lo, _MM_SHUFFLE(3, 3, 1, 0)));
+                const __m128 w = Swizzle<0, 2, 2, 3>(_mm_shuffle_ps(hi, lo, _MM_SHUFFLE(1, 2, 0, 0)));
+                const __m128 x = Swizzle<3, 1, 0, 0>(lo);
+
+                return _mm_add_ps(_mm_sub_ps(_mm_mul_ps(v, Swizzle<1, 0, 0, 0>(r)), _mm_mul_ps(w, Swizzle<2, 2, 1, 1>(r))), _mm_mul_ps(x, Swizzle<3, 3, 3, 2>(r)));
+            };
+
+            const __m128 sign_odd  = _mm_set_ps(-0.0f, 0.0f, -0.0f, 0.0f);
+            const __m128 sign_even = _mm_set_ps(0.0f, -0.0f, 0.0f, -0.0f);
+            const __m128 i0        = Negate(column(a_lo, a_hi, r1), sign_odd);
+            const __m128 i1        = Negate(column(a_lo, a_hi, r0), sign_even);
+            const __m128 i2        = Negate(column(b_lo, b_hi, r0), sign_odd);
+            const __m128 i3        = Negate(column(c_lo, c_hi, r0), sign_even);
+
+            alignas(16) float det[4];
+            _mm_store_ps(det, _mm_mul_ps(i0, r0));
+            const __m128 inv_det = _mm_set1_ps(1.0f / (det[0] + det[1] + det[2] + det[3]));
+
+            Matrix result;
+            _mm_storeu_ps(&result.m00, _mm_mul_ps(i0, inv_det));
+            _mm_storeu_ps(&result.m01, _mm_mul_ps(i1, inv_det));
+            _mm_storeu_ps(&result.m02, _mm_mul_ps(i2, inv_det));
+            _mm_storeu_ps(&result.m03, _mm_mul_ps(i3, inv_det));
+
+            return result;
+        #else
             float v0 = matrix.m20 * matrix.m31 - matrix.m21 * matrix.m30;
             float v1 = matrix.m20 * matrix.m32 - matrix.m22 * matrix.m30;
             float v2 = matrix.m20 * matrix.m33 - matrix.m23 *matrix.m30;
@@ -345,6 +438,7 @@ namespace Spartan::Math
                 i10, i11, i12, i13,
                 i20, i21, i22, i23,
                 i30, i31, i32, i33);
+        #endif
         }
         //================================================================================================
 
@@ -366,6 +460,45 @@ namespace Spartan::Math
         //= MULTIPLICATION ===========================================================================
         Matrix operator*(const Matrix& rhs) const
         {
+        #if SP_SIMD_SSE
+            // column j of the result is the columns of this matrix, weighted by the elements of column j of rhs
+            const __m128 c0 = _mm_loadu_ps(&m00);
+            const __m128 c1 = _mm_loadu_ps(&m01);
+            const __m128 c2 = _mm_loadu_ps(&m02);
+            const __m128 c3 = _mm_loadu_ps(&m03);
+
+            Matrix result;
+            const float* rhs_columns = rhs.Data();
+            float* result_columns    = &result.m00;
+        #if SP_SIMD_AVX
+            // two columns at a time
+            const __m256 c0_x2 = _mm256_insertf128_ps(_mm256_castps128_ps256(c0), c0, 1);
+            const __m256 c1_x2 = _mm256_insertf128_ps(_mm256_castps128_ps256(c1), c1, 1);
+            const __m256 c2_x2 = _mm256_insertf128_ps(_mm256_castps128_ps256(c2), c2, 1);
+            const __m256 c3_x2 = _mm256_insertf128_ps(_mm256_castps128_ps256(c3), c3, 1);
+            for (uint32_t j = 0; j < 4; j += 2)
+            {
+                const __m256 weights = _mm256_loadu_ps(rhs_columns + 4 * j);
+                __m256 column        = _mm256_mul_ps(c0_x2, _mm256_shuffle_ps(weights, weights, _MM_SHUFFLE(0, 0, 0, 0)));
+                column               = _mm256_add_ps(column, _mm256_mul_ps(c1_x2, _mm256_shuffle_ps(weights, weights, _MM_SHUFFLE(1, 1, 1, 1))));
+                column               = _mm256_add_ps(column, _mm256_mul_ps(c2_x2, _mm256_shuffle_ps(weights, weights, _MM_SHUFFLE(2, 2, 2, 2))));
+                column               = _mm256_add_ps(column, _mm256_mul_ps(c3_x2, _mm256_shuffle_ps(weights, weights, _MM_SHUFFLE(3, 3, 3, 3))));
+                _mm256_storeu_ps(result_columns + 4 * j, column);
+            }
+        #else
+            for (uint32_t j = 0; j < 4; j++)
+            {
+                const __m128 weights = _mm_loadu_ps(rhs_columns + 4 * j);
+                __m128 column        = _mm_mul_ps(c0, Simd::Swizzle<0, 0, 0, 0>(weights));
+                column               = _mm_add_ps(column, _mm_mul_ps(c1, Simd::Swizzle<1, 1, 1, 1>(weights)));
+                column               = _mm_add_ps(column, _mm_mul_ps(c2, Simd::Swizzle<2, 2, 2, 2>(weights)));
+                column               = _mm_add_ps(column, _mm_mul_ps(c3, Simd::Swizzle<3, 3, 3, 3>(weights)));
+                _mm_storeu_ps(result_columns + 4 * j, column);
+            }
+        #endif
+
+            return result;
+        #else
             return Matrix(
                 m00 * rhs.m00 + m01 * rhs.m10 + m02 * rhs.m20 + m03 * rhs.m30,
                 m00 * rhs.m01 + m01 * rhs.m11 + m02 * rhs.m21 + m03 * rhs.m31,
@@ -384,12 +517,28 @@ namespace Spartan::Math
                 m30 * rhs.m02 + m31 * rhs.m12 + m32 * rhs.m22 + m33 * rhs.m32,
                 m30 * rhs.m03 + m31 * rhs.m13 + m32 * rhs.m23 + m33 * rhs.m33
             );
+        #endif
         }
 
         void operator*=(const Matrix& rhs) { (*this) = (*this) * rhs; }
 
         Vector3 operator*(const Vector3& rhs) const
         {
+        #if SP_SIMD_SSE
+            __m128 r0 = _mm_loadu_ps(&m00);
+            __m128 r1 = _mm_loadu_ps(&m01);
+            __m128 r2 = _mm_loadu_ps(&m02);
+            __m128 r3 = _mm_loadu_ps(&m03);
+            _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+
+            const __m128 working = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(rhs.x), r0), _mm_mul_ps(_mm_set1_ps(rhs.y), r1)), _mm_mul_ps(_mm_set1_ps(rhs.z), r2)), r3);
+            const __m128 w       = _mm_div_ps(_mm_set1_ps(1.0f), Simd::Swizzle<3, 3, 3, 3>(working));
+
+            alignas(16) float result[4];
+            _mm_store_ps(result, _mm_mul_ps(working, w));
+
+            return Vector3(result[0], result[1], result[2]);
+        #else
             Vector4 vWorking;
 
             vWorking.x = (rhs.x * m00) + (rhs.y * m10) + (rhs.z * m20) + m30;
@@ -398,10 +547,23 @@ namespace Spartan::Math
             vWorking.w = 1 / ((rhs.x * m03) + (rhs.y * m13) + (rhs.z * m23) + m33);
 
             return Vector3(vWorking.x * vWorking.w, vWorking.y * vWorking.w, vWorking.z * vWorking.w);
+        #endif
         }
 
         Vector4 operator*(const Vector4& rhs) const
         {
+        #if SP_SIMD_SSE
+            __m128 r0 = _mm_loadu_ps(&m00);
+            __m128 r1 = _mm_loadu_ps(&m01);
+            __m128 r2 = _mm_loadu_ps(&m02);
+            __m128 r3 = _mm_loadu_ps(&m03);
+            _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+
+            alignas(16) float result[4];
+            _mm_store_ps(result, _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(rhs.x), r0), _mm_mul_ps(_mm_set1_ps(rhs.y), r1)), _mm_mul_ps(_mm_set1_ps(rhs.z), r2)), _mm_mul_ps(_mm_set1_ps(rhs.w), r3)));
+
+            return Vector4(result[0], result[1], result[2], result[3]);
+        #else
             return Vector4
             (
                 (rhs.x * m00) + (rhs.y * m10) + (rhs.z * m20) + (rhs.w * m30),
@@ -409,6 +571,7 @@ namespace Spartan::Math
                 (rhs.x * m02) + (rhs.y * m12) + (rhs.z * m22) + (rhs.w * m32),
                 (rhs.x * m03) + (rhs.y * m13) + (rhs.z * m23) + (rhs.w * m33)
             );
+        #endif
         }
         //============================================================================================
 
@@ -23,6 +23,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 //= INCLUDES =======
 #include "Vector3.h"
+#include "Simd.h"
 //==================
 
 namespace Spartan::Math
@@ -185,6 +186,20 @@ namespace Spartan::Math
 
         static inline Quaternion Multiply(const Quaternion& Qa, const Quaternion& Qb)
         {
+        #if SP_SIMD_SSE
+            using namespace Simd;
+
+            // x, y and z in the first three lanes, w is done on its own, with the same order of operations as below
+            const __m128 a     = _mm_loadu_ps(&Qa.x);
+            const __m128 b     = _mm_loadu_ps(&Qb.x);
+            const __m128 cross = _mm_sub_ps(_mm_mul_ps(Swizzle<1, 2, 0, 3>(a), Swizzle<2, 0, 1, 3>(b)), _mm_mul_ps(Swizzle<2, 0, 1, 3>(a), Swizzle<1, 2, 0, 3>(b)));
+            const __m128 xyz   = _mm_add_ps(_mm_add_ps(_mm_mul_ps(a, Swizzle<3, 3, 3, 3>(b)), _mm_mul_ps(b, Swizzle<3, 3, 3, 3>(a))), cross);
+
+            alignas(16) float result[4];
+            _mm_store_ps(result, xyz);
+
+            return Quaternion(result[0], result[1], result[2], (Qa.w * Qb.w) - (((Qa.x * Qb.x) + (Qa.y * Qb.y)) + (Qa.z * Qb.z)));
+        #else
             const float x     = Qa.x;
             const float y     = Qa.y;
             const float z     = Qa.z;
@@ -204,6 +219,7 @@ namespace Spartan::Math
                 ((z * num) + (num2 * w)) + num10,
                 (w * num) - num9
             );
+        #endif
         }
 
         auto Conjugate() const      { return Quaternion(-x, -y, -z, w); }
@@ -0,0 +1,81 @@
+/*
+Copyright(c) 2016-2023 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+// x64 always has SSE2, AVX has to be checked for at runtime (see HasAvx()), unless the build targets it (SP_SIMD_AVX).
+// Define SP_SIMD_DISABLED to build the scalar paths instead, e.g. to compare results against them.
+#if (defined(_M_X64) || defined(__x86_64__)) && !defined(SP_SIMD_DISABLED)
+    #define SP_SIMD_SSE 1
+    #include <immintrin.h>
+    #if defined(_MSC_VER)
+        #include <intrin.h>
+    #endif
+#else
+    #define SP_SIMD_SSE 0
+#endif
+
+// set by /arch:AVX, /arch:AVX2, -mavx, -mavx2 and so on
+#if SP_SIMD_SSE && defined(__AVX__)
+    #define SP_SIMD_AVX 1
+#else
+    #define SP_SIMD_AVX 0
+#endif
+
+// GCC and Clang only accept AVX intrinsics in functions which are compiled for AVX, MSVC accepts them anywhere
+#if SP_SIMD_SSE && (defined(__GNUC__) || defined(__clang__))
+    #define SP_SIMD_TARGET_AVX __attribute__((target("avx")))
+#else
+    #define SP_SIMD_TARGET_AVX
+#endif
+
+namespace Spartan::Math::Simd
+{
+    inline bool HasAvx()
+    {
+        static const bool has_avx = []()
+        {
+            #if !SP_SIMD_SSE
+                return false;
+            #elif defined(_MSC_VER)
+                // the cpu has to support it, and the os has to save the ymm registers (osxsave, xcr0 bits 1 and 2)
+                int info[4] = {};
+                __cpuid(info, 1);
+                const bool cpu_avx    = (info[2] & (1 << 28)) != 0;
+                const bool os_osxsave  = (info[2] & (1 << 27)) != 0;
+                return cpu_avx && os_osxsave && (_xgetbv(0) & 0x6) == 0x6;
+            #else
+                return __builtin_cpu_supports("avx") != 0;
+            #endif
+        }();
+
+        return has_avx;
+    }
+
+    #if SP_SIMD_SSE
+    // returns (v[a], v[b], v[c], v[d])
+    template<int a, int b, int c, int d>
+    inline __m128 Swizzle(const __m128 v) { return _mm_shuffle_ps(v, v, _MM_SHUFFLE(d, c, b, a)); }
+
+    // flips the sign of the lanes which are set to -0.0f in mask, which is exactly what a unary minus does
+    inline __m128 Negate(const __m128 v, const __m128 mask) { return _mm_xor_ps(v, mask); }
+    #endif
+}
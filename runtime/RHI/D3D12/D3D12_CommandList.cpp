@@ -171,7 +171,7 @@ namespace Spartan
         Profiler::m_rhi_draw++;
     }
     
-    void RHI_CommandList::DrawIndexed(const uint32_t index_count, const uint32_t index_offset, const uint32_t vertex_offset, const uint32_t instance_count)
+    void RHI_CommandList::DrawIndexed(const uint32_t index_count, const uint32_t index_offset, const uint32_t vertex_offset, const uint32_t instance_count, const uint32_t instance_start)
     {
         // Validate command list state
         SP_ASSERT(m_state == RHI_CommandListState::Recording);
@@ -181,11 +181,11 @@ namespace Spartan
 
         // Draw
         static_cast<ID3D12GraphicsCommandList*>(m_rhi_resource)->DrawIndexedInstanced(
-            index_count,   // IndexCountPerInstance
-            1,             // InstanceCount
-            index_offset,  // StartIndexLocation
-            vertex_offset, // BaseVertexLocation
-            0              // StartInstanceLocation
+            index_count,    // IndexCountPerInstance
+            instance_count, // InstanceCount
+            index_offset,   // StartIndexLocation
+            vertex_offset,  // BaseVertexLocation
+            instance_start  // StartInstanceLocation
         );
 
         // Profile
@@ -70,7 +70,7 @@ namespace Spartan
 
         // Draw
         void Draw(const uint32_t vertex_count, const uint32_t vertex_start_index = 0);
-        void DrawIndexed(const uint32_t index_count, const uint32_t index_offset = 0, const uint32_t vertex_offset = 0, const uint32_t instance_count = 1);
+        void DrawIndexed(const uint32_t index_count, const uint32_t index_offset = 0, const uint32_t vertex_offset = 0, const uint32_t instance_count = 1, const uint32_t instance_start = 0);
 
         // Dispatch
         void Dispatch(uint32_t x, uint32_t y, uint32_t z = 1, bool async = false);
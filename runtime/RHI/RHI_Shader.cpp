@@ -107,14 +107,33 @@ namespace Spartan
             return;
         }
 
-        // load
-        LoadFromDrive(file_path);
+        m_compilation_state = RHI_ShaderCompilationState::Idle;
 
-        // compile
+        if (!async)
         {
-            m_compilation_state = RHI_ShaderCompilationState::Idle;
+            // load
+            LoadFromDrive(file_path);
 
-            if (!async)
+            // time compilation
+            const Stopwatch timer;
+
+            // compile
+            m_compilation_state = RHI_ShaderCompilationState::Compiling;
+            m_rhi_resource      = RHI_Compile();
+            m_compilation_state = m_rhi_resource ? RHI_ShaderCompilationState::Succeeded : RHI_ShaderCompilationState::Failed;
+
+            // log compilation result
+            log_compilation_result(shader_type, m_defines, m_compilation_state, m_object_name, timer);
+        }
+        else
+        {
+            // load (and preprocess includes), then compile
+            JobHandle job_load = ThreadPool::CreateJob([this, file_path]()
+            {
+                LoadFromDrive(file_path);
+            });
+
+            JobHandle job_compile = ThreadPool::CreateJob([this, shader_type]()
             {
                 // time compilation
                 const Stopwatch timer;
@@ -126,23 +145,11 @@ namespace Spartan
 
                 // log compilation result
                 log_compilation_result(shader_type, m_defines, m_compilation_state, m_object_name, timer);
-            }
-            else
-            {
-                ThreadPool::AddTask([this, shader_type]()
-                {
-                    // time compilation
-                    const Stopwatch timer;
-
-                    // compile
-                    m_compilation_state = RHI_ShaderCompilationState::Compiling;
-                    m_rhi_resource      = RHI_Compile();
-                    m_compilation_state = m_rhi_resource ? RHI_ShaderCompilationState::Succeeded : RHI_ShaderCompilationState::Failed;
+            });
 
-                    // log compilation result
-                    log_compilation_result(shader_type, m_defines, m_compilation_state, m_object_name, timer);
-                });
-            }
+            ThreadPool::AddContinuation(job_load, job_compile);
+            ThreadPool::Run(job_compile);
+            ThreadPool::Run(job_load);
         }
     }
 
@@ -24,6 +24,8 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "RHI_Texture.h"
 #include "RHI_Device.h"
 #include "../IO/FileStream.h"
+#include "../IO/AssetFile.h"
+#include "../Core/ThreadPool.h"
 #include "../Rendering/Renderer.h"
 #include "../Resource/Import/ImageImporterExporter.h"
 SP_WARNINGS_OFF
@@ -37,6 +39,44 @@ using namespace std;
 
 namespace Spartan
 {
+    namespace
+    {
+        // stored in the properties chunk of native texture files
+        struct texture_properties
+        {
+            uint64_t object_size_cpu  = 0;
+            uint64_t object_id        = 0;
+            uint32_t array_length     = 0;
+            uint32_t mip_count        = 0;
+            uint32_t mip_count_stored = 0; // mips per slice which have data in the file
+            uint32_t width            = 0;
+            uint32_t height           = 0;
+            uint32_t channel_count    = 0;
+            uint32_t bits_per_channel = 0;
+            uint32_t format           = 0;
+            uint32_t flags            = 0;
+            uint32_t padding          = 0;
+        };
+
+        // reads the data of a native texture file which was written before the asset container
+        void read_legacy_data(FileStream* file, uint64_t* object_size_cpu, uint32_t* array_length, uint32_t* mip_count, vector<RHI_Texture_Slice>* slices)
+        {
+            file->Read(object_size_cpu);
+            file->Read(array_length);
+            file->Read(mip_count);
+
+            slices->resize(*array_length);
+            for (RHI_Texture_Slice& slice : *slices)
+            {
+                slice.mips.resize(*mip_count);
+                for (RHI_Texture_Mip& mip : slice.mips)
+                {
+                    file->Read(&mip.bytes);
+                }
+            }
+        }
+    }
+
     namespace amd_compressonator
     {
         CMP_FORMAT rhi_format_to_compressonator_format(const RHI_Format format)
@@ -208,68 +248,112 @@ namespace Spartan
 
     bool RHI_Texture::SaveToFile(const string& file_path)
     {
-        // if a file already exists, get the byte count
-        m_object_size_cpu = 0;
+        // once saved, the data is freed, so when saving again the mips come from the existing file
+        unique_ptr<AssetFileReader> existing;
+        vector<RHI_Texture_Slice> legacy_slices;
+        uint32_t mip_count_existing = 0;
+        if (!HasData() && FileSystem::Exists(file_path))
         {
-            if (FileSystem::Exists(file_path))
+            existing = make_unique<AssetFileReader>(file_path);
+            if (existing->IsOpen())
+            {
+                texture_properties properties;
+                if (existing->Read(AssetChunkType::Properties, 0, &properties, sizeof(properties)))
+                {
+                    m_object_size_cpu  = properties.object_size_cpu;
+                    mip_count_existing = properties.mip_count_stored;
+
+                    // already a current container, nothing to convert
+                    if (existing->GetVersion() == asset_file_version)
+                        return true;
+                }
+            }
+            else
             {
-                auto file = make_unique<FileStream>(file_path, FileStream_Read);
+                // converted to the container, so the data has to be read back in
+                existing = nullptr;
+                auto file = make_unique<FileStream>(file_path, FileStream_Read | FileStream_Mapped);
                 if (file->IsOpen())
                 {
-                    file->Read(&m_object_size_cpu);
+                    uint32_t array_length = 0;
+                    uint32_t mip_count    = 0;
+                    read_legacy_data(file.get(), &m_object_size_cpu, &array_length, &mip_count, &legacy_slices);
                 }
             }
         }
-
-        bool append = true;
-        auto file = make_unique<FileStream>(file_path, FileStream_Write | FileStream_Append);
-        if (!file->IsOpen())
-            return false;
-
-        // if the existing file has texture data but we don't, don't overwrite them
-        bool dont_overwrite_data = m_object_size_cpu != 0 && !HasData();
-        if (dont_overwrite_data)
-        {
-            file->Skip
-            (
-                sizeof(m_object_size_cpu) + // byte count
-                sizeof(m_array_length)    + // array length
-                sizeof(m_mip_count)       + // mip count
-                m_object_size_cpu           // bytes
-            );
-        }
         else
         {
             ComputeMemoryUsage();
+        }
 
-            // write mip info
-            file->Write(m_object_size_cpu);
-            file->Write(m_array_length);
-            file->Write(m_mip_count);
+        // the existing file is still being read from, so a carried over file is written next to it and then swapped in
+        const string file_path_write = existing ? file_path + ".tmp" : file_path;
+        {
+            AssetFileWriter file(file_path_write);
+            if (!file.IsOpen())
+                return false;
+
+            const vector<RHI_Texture_Slice>& slices = legacy_slices.empty() ? m_slices : legacy_slices;
+
+            texture_properties properties;
+            properties.object_size_cpu  = m_object_size_cpu;
+            properties.object_id        = GetObjectId();
+            properties.array_length     = m_array_length;
+            properties.mip_count        = m_mip_count;
+            properties.mip_count_stored = existing ? mip_count_existing : (slices.empty() ? 0 : static_cast<uint32_t>(slices[0].mips.size()));
+            properties.width            = m_width;
+            properties.height           = m_height;
+            properties.channel_count    = m_channel_count;
+            properties.bits_per_channel = m_bits_per_channel;
+            properties.format           = static_cast<uint32_t>(m_format);
+            properties.flags            = m_flags;
+            file.AddChunk(AssetChunkType::Properties, 0, &properties, sizeof(properties));
+            file.AddChunk(AssetChunkType::Path, 0, GetResourceFilePath());
 
             // write mip data
-            for (RHI_Texture_Slice& slice : m_slices)
+            if (existing)
             {
-                for (RHI_Texture_Mip& mip : slice.mips)
+                for (const AssetChunkInfo& chunk : existing->GetChunks())
                 {
-                    file->Write(mip.bytes);
+                    span<const std::byte> bytes;
+                    if (chunk.type == AssetChunkType::Mip && existing->GetChunk(chunk.type, chunk.index, &bytes))
+                    {
+                        file.CopyChunk(chunk, bytes);
+                    }
                 }
             }
+            else
+            {
+                // pixels compress well with the vertex codec, which works on the deltas of neighbouring elements
+                const uint32_t stride = min(((GetBytesPerPixel() + 3) / 4) * 4, 256u);
 
-            // the bytes have been saved, so we can now free some memory
-            m_slices.clear();
-            m_slices.shrink_to_fit();
+                for (uint32_t slice_index = 0; slice_index < static_cast<uint32_t>(slices.size()); slice_index++)
+                {
+                    const vector<RHI_Texture_Mip>& mips = slices[slice_index].mips;
+                    for (uint32_t mip_index = 0; mip_index < min(properties.mip_count_stored, static_cast<uint32_t>(mips.size())); mip_index++)
+                    {
+                        const vector<std::byte>& bytes = mips[mip_index].bytes;
+                        file.AddChunk(AssetChunkType::Mip, slice_index * properties.mip_count_stored + mip_index, bytes.data(), bytes.size(), AssetCompression::Vertex, stride);
+                    }
+                }
+            }
+
+            if (!file.Close())
+                return false;
+
+            m_file_size              = file.GetSize();
+            m_file_size_uncompressed = file.GetSizeUncompressed();
         }
 
-        // write properties
-        file->Write(m_width);
-        file->Write(m_height);
-        file->Write(m_channel_count);
-        file->Write(m_bits_per_channel);
-        file->Write(static_cast<uint32_t>(m_format));
-        file->Write(m_flags);
-        file->Write(GetObjectId());
-        file->Write(GetResourceFilePath());
+        if (existing)
+        {
+            existing = nullptr;
+            FileSystem::Rename(file_path_write, file_path);
+        }
+
+        // the bytes have been saved, so we can now free some memory
+        m_slices.clear();
+        m_slices.shrink_to_fit();
 
         return true;
     }
@@ -289,38 +373,83 @@ namespace Spartan
         {
             if (FileSystem::IsEngineTextureFile(file_path))
             {
-                auto file = make_unique<FileStream>(file_path, FileStream_Read);
-                if (!file->IsOpen())
+                AssetFileReader reader(file_path);
+                if (reader.IsOpen())
                 {
-                    SP_LOG_ERROR("Failed to load \"%s\".", file_path.c_str());
-                    return false;
-                }
+                    // read properties
+                    texture_properties properties;
+                    string resource_file_path;
+                    if (!reader.Read(AssetChunkType::Properties, 0, &properties, sizeof(properties)) || !reader.Read(AssetChunkType::Path, 0, &resource_file_path))
+                    {
+                        SP_LOG_ERROR("Failed to load \"%s\".", file_path.c_str());
+                        return false;
+                    }
 
-                // read mip info
-                file->Read(&m_object_size_cpu);
-                file->Read(&m_array_length);
-                file->Read(&m_mip_count);
+                    m_object_size_cpu  = properties.object_size_cpu;
+                    m_array_length     = properties.array_length;
+                    m_mip_count        = properties.mip_count;
+                    m_width            = properties.width;
+                    m_height           = properties.height;
+                    m_channel_count    = properties.channel_count;
+                    m_bits_per_channel = properties.bits_per_channel;
+                    m_format           = static_cast<RHI_Format>(properties.format);
+                    m_flags            = properties.flags;
+                    SetObjectId(properties.object_id);
+                    SetResourceFilePath(resource_file_path);
+
+                    // read mip data, decompressing all the mips in parallel
+                    m_slices.resize(m_array_length);
+                    for (RHI_Texture_Slice& slice : m_slices)
+                    {
+                        slice.mips.resize(properties.mip_count_stored);
+                    }
 
-                // read mip data
-                m_slices.resize(m_array_length);
-                for (RHI_Texture_Slice& slice : m_slices)
-                {
-                    slice.mips.resize(m_mip_count);
-                    for (RHI_Texture_Mip& mip : slice.mips)
+                    atomic<bool> failed = false;
+                    auto read_mips = [this, &reader, &properties, &failed](uint32_t index_start, uint32_t index_end)
                     {
-                        file->Read(&mip.bytes);
+                        for (uint32_t i = index_start; i < index_end; i++)
+                        {
+                            vector<std::byte>& bytes = m_slices[i / properties.mip_count_stored].mips[i % properties.mip_count_stored].bytes;
+                            if (!reader.Read(AssetChunkType::Mip, i, &bytes))
+                            {
+                                failed = true;
+                            }
+                        }
+                    };
+                    ThreadPool::ParallelLoop(read_mips, m_array_length * properties.mip_count_stored);
+
+                    if (failed)
+                    {
+                        SP_LOG_ERROR("Failed to read the mips of \"%s\".", file_path.c_str());
+                        return false;
                     }
+
+                    m_file_size              = reader.GetSize();
+                    m_file_size_uncompressed = reader.GetSizeUncompressed();
                 }
+                else
+                {
+                    // files written before the asset container
+                    auto file = make_unique<FileStream>(file_path, FileStream_Read | FileStream_Mapped);
+                    if (!file->IsOpen())
+                    {
+                        SP_LOG_ERROR("Failed to load \"%s\".", file_path.c_str());
+                        return false;
+                    }
 
-                // read properties
-                file->Read(&m_width);
-                file->Read(&m_height);
-                file->Read(&m_channel_count);
-                file->Read(&m_bits_per_channel);
-                file->Read(reinterpret_cast<uint32_t*>(&m_format));
-                file->Read(&m_flags);
-                SetObjectId(file->ReadAs<uint64_t>());
-                SetResourceFilePath(file->ReadAs<string>());
+                    // read mip info and data
+                    read_legacy_data(file.get(), &m_object_size_cpu, &m_array_length, &m_mip_count, &m_slices);
+
+                    // read properties
+                    file->Read(&m_width);
+                    file->Read(&m_height);
+                    file->Read(&m_channel_count);
+                    file->Read(&m_bits_per_channel);
+                    file->Read(reinterpret_cast<uint32_t*>(&m_format));
+                    file->Read(&m_flags);
+                    SetObjectId(file->ReadAs<uint64_t>());
+                    SetResourceFilePath(file->ReadAs<string>());
+                }
             }
             else if (FileSystem::IsSupportedImageFile(file_path))
             {
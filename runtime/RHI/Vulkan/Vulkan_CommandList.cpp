@@ -716,7 +716,7 @@ namespace Spartan
         }
     }
 
-    void RHI_CommandList::DrawIndexed(const uint32_t index_count, const uint32_t index_offset, const uint32_t vertex_offset, const uint32_t instance_count)
+    void RHI_CommandList::DrawIndexed(const uint32_t index_count, const uint32_t index_offset, const uint32_t vertex_offset, const uint32_t instance_count, const uint32_t instance_start)
     {
         SP_ASSERT(m_state == RHI_CommandListState::Recording);
         OnDraw();
@@ -727,7 +727,7 @@ namespace Spartan
             instance_count,                               // instanceCount
             index_offset,                                 // firstIndex
             vertex_offset,                                // vertexOffset
-            0                                             // firstInstance
+            instance_start                                // firstInstance
         );
 
         if (Profiler::m_granularity == ProfilerGranularity::Full)
@@ -30,6 +30,8 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "../World/Entity.h"
 #include "../Resource/ResourceCache.h"
 #include "../IO/FileStream.h"
+#include "../IO/AssetFile.h"
+#include "../Core/ThreadPool.h"
 #include "../Resource/Import/ModelImporter.h"
 SP_WARNINGS_OFF
 #include "meshoptimizer/meshoptimizer.h"
@@ -61,6 +63,15 @@ namespace Spartan
 
         m_vertices.clear();
         m_vertices.shrink_to_fit();
+
+        m_submeshes.clear();
+        m_submeshes.shrink_to_fit();
+
+        m_lods.clear();
+        m_lods.shrink_to_fit();
+
+        m_lod_indices.clear();
+        m_lod_indices.shrink_to_fit();
     }
 
     bool Mesh::LoadFromFile(const string& file_path)
@@ -77,15 +88,68 @@ namespace Spartan
         if (FileSystem::GetExtensionFromFilePath(file_path) == EXTENSION_MODEL)
         {
             // deserialize
-            auto file = make_unique<FileStream>(file_path, FileStream_Read);
-            if (!file->IsOpen())
-                return false;
-
-            SetResourceFilePath(file->ReadAs<string>());
-            file->Read(&m_indices);
-            file->Read(&m_vertices);
+            AssetFileReader reader(file_path);
+            if (reader.IsOpen())
+            {
+                string resource_file_path;
+                if (!reader.Read(AssetChunkType::Path, 0, &resource_file_path) || !reader.Read(AssetChunkType::Submeshes, 0, &m_submeshes))
+                    return false;
+
+                SetResourceFilePath(resource_file_path);
+
+                // submeshes are stored back to back, so the totals come from the last one
+                const MeshSubmesh last = m_submeshes.empty() ? MeshSubmesh() : m_submeshes.back();
+                m_indices.resize(last.index_offset + last.index_count);
+                m_vertices.resize(last.vertex_offset + last.vertex_count);
+
+                // decompress the submeshes in parallel, each one into its own range
+                atomic<bool> failed = false;
+                auto read_submeshes = [this, &reader, &failed](uint32_t index_start, uint32_t index_end)
+                {
+                    for (uint32_t i = index_start; i < index_end; i++)
+                    {
+                        const MeshSubmesh& submesh = m_submeshes[i];
+                        if (!reader.Read(AssetChunkType::Indices,  i, m_indices.data()  + submesh.index_offset,  submesh.index_count  * sizeof(uint32_t)) ||
+                            !reader.Read(AssetChunkType::Vertices, i, m_vertices.data() + submesh.vertex_offset, submesh.vertex_count * sizeof(RHI_Vertex_PosTexNorTan)))
+                        {
+                            failed = true;
+                        }
+                    }
+                };
+                ThreadPool::ParallelLoop(read_submeshes, static_cast<uint32_t>(m_submeshes.size()));
+
+                if (failed)
+                {
+                    SP_LOG_ERROR("Failed to read the submeshes of \"%s\"", file_path.c_str());
+                    return false;
+                }
+
+                // lods are optional, files can be written without them
+                if (reader.HasChunk(AssetChunkType::Lods))
+                {
+                    if (!reader.Read(AssetChunkType::Lods, 0, &m_lods) || !reader.Read(AssetChunkType::LodIndices, 0, &m_lod_indices) ||
+                        m_lods.size() != m_submeshes.size() * (mesh_lod_count - 1))
+                    {
+                        SP_LOG_WARNING("Failed to read the lods of \"%s\", they will be regenerated", file_path.c_str());
+                        GenerateLods();
+                    }
+                }
+
+                m_file_size              = reader.GetSize();
+                m_file_size_uncompressed = reader.GetSizeUncompressed();
+            }
+            else
+            {
+                // files written before the asset container
+                auto file = make_unique<FileStream>(file_path, FileStream_Read | FileStream_Mapped);
+                if (!file->IsOpen())
+                    return false;
+
+                SetResourceFilePath(file->ReadAs<string>());
+                file->Read(&m_indices);
+                file->Read(&m_vertices);
+            }
 
-            //Optimize();
             ComputeAabb();
             ComputeNormalizedScale();
             CreateGpuBuffers();
@@ -119,24 +183,70 @@ namespace Spartan
 
     bool Mesh::SaveToFile(const string& file_path)
     {
-        auto file = make_unique<FileStream>(file_path, FileStream_Write);
-        if (!file->IsOpen())
+        AssetFileWriter file(file_path);
+        if (!file.IsOpen())
             return false;
 
-        file->Write(GetResourceFilePath());
-        file->Write(m_indices);
-        file->Write(m_vertices);
+        // geometry which wasn't added through AddGeometry() is stored as a single submesh
+        vector<MeshSubmesh> submeshes = m_submeshes;
+        {
+            uint32_t index_count  = 0;
+            uint32_t vertex_count = 0;
+            for (const MeshSubmesh& submesh : submeshes)
+            {
+                index_count  += submesh.index_count;
+                vertex_count += submesh.vertex_count;
+            }
+
+            if (index_count != GetIndexCount() || vertex_count != GetVertexCount())
+            {
+                submeshes.clear();
+                submeshes.push_back({ 0, GetIndexCount(), 0, GetVertexCount() });
+            }
+        }
+
+        file.AddChunk(AssetChunkType::Path, 0, GetResourceFilePath());
+        file.AddChunk(AssetChunkType::Submeshes, 0, submeshes);
+        for (uint32_t i = 0; i < static_cast<uint32_t>(submeshes.size()); i++)
+        {
+            const MeshSubmesh& submesh = submeshes[i];
+            file.AddChunk(AssetChunkType::Indices,  i, m_indices.data()  + submesh.index_offset,  submesh.index_count  * sizeof(uint32_t),                AssetCompression::Index,  sizeof(uint32_t));
+            file.AddChunk(AssetChunkType::Vertices, i, m_vertices.data() + submesh.vertex_offset, submesh.vertex_count * sizeof(RHI_Vertex_PosTexNorTan), AssetCompression::Vertex, sizeof(RHI_Vertex_PosTexNorTan));
+        }
+
+        // lods refer to the submeshes, so they are only stored if the submeshes are
+        if (HasLods() && submeshes.size() == m_submeshes.size())
+        {
+            file.AddChunk(AssetChunkType::Lods, 0, m_lods);
+            file.AddChunk(AssetChunkType::LodIndices, 0, m_lod_indices.data(), m_lod_indices.size() * sizeof(uint32_t), AssetCompression::Index, sizeof(uint32_t));
+        }
+
+        if (!file.Close())
+            return false;
 
-        file->Close();
+        m_file_size              = file.GetSize();
+        m_file_size_uncompressed = file.GetSizeUncompressed();
 
         return true;
     }
 
+    bool Mesh::LoadSubmeshFromFile(const string& file_path, const uint32_t submesh_index, vector<uint32_t>* indices, vector<RHI_Vertex_PosTexNorTan>* vertices)
+    {
+        AssetFileReader reader(file_path);
+        if (!reader.IsOpen())
+            return false;
+
+        return (!indices  || reader.Read(AssetChunkType::Indices,  submesh_index, indices)) &&
+               (!vertices || reader.Read(AssetChunkType::Vertices, submesh_index, vertices));
+    }
+
     uint32_t Mesh::GetMemoryUsage() const
     {
         uint32_t size = 0;
         size += uint32_t(m_indices.size()  * sizeof(uint32_t));
         size += uint32_t(m_vertices.size() * sizeof(RHI_Vertex_PosTexNorTan));
+        size += uint32_t(m_lod_indices.size() * sizeof(uint32_t));
+        size += uint32_t(m_lods.size() * sizeof(MeshLod));
 
         return size;
     }
@@ -176,6 +286,31 @@ namespace Spartan
         m_vertices.insert(m_vertices.end(), vertices.begin(), vertices.end());
     }
 
+    void Mesh::AddGeometry(const vector<RHI_Vertex_PosTexNorTan>& vertices, const vector<uint32_t>& indices, uint32_t* vertex_offset_out /*= nullptr*/, uint32_t* index_offset_out /*= nullptr*/)
+    {
+        // both locks, so that the submesh is contiguous with the previous one
+        scoped_lock lock(m_mutex_vertices, m_mutex_indices);
+
+        MeshSubmesh& submesh  = m_submeshes.emplace_back();
+        submesh.index_offset  = static_cast<uint32_t>(m_indices.size());
+        submesh.index_count   = static_cast<uint32_t>(indices.size());
+        submesh.vertex_offset = static_cast<uint32_t>(m_vertices.size());
+        submesh.vertex_count  = static_cast<uint32_t>(vertices.size());
+
+        if (vertex_offset_out)
+        {
+            *vertex_offset_out = submesh.vertex_offset;
+        }
+
+        if (index_offset_out)
+        {
+            *index_offset_out = submesh.index_offset;
+        }
+
+        m_indices.insert(m_indices.end(), indices.begin(), indices.end());
+        m_vertices.insert(m_vertices.end(), vertices.begin(), vertices.end());
+    }
+
     void Mesh::AddIndices(const vector<uint32_t>& indices, uint32_t* index_offset_out /*= nullptr*/)
     {
         lock_guard lock(m_mutex_vertices);
@@ -209,10 +344,11 @@ namespace Spartan
     {
         return
             static_cast<uint32_t>(MeshFlags::ImportRemoveRedundantData) |
-            static_cast<uint32_t>(MeshFlags::ImportNormalizeScale);
-            //static_cast<uint32_t>(MeshFlags::OptimizeVertexCache) |
-            //static_cast<uint32_t>(MeshFlags::OptimizeOverdraw) |
-            //static_cast<uint32_t>(MeshFlags::OptimizeVertexFetch);
+            static_cast<uint32_t>(MeshFlags::ImportNormalizeScale)      |
+            static_cast<uint32_t>(MeshFlags::OptimizeVertexCache)       |
+            static_cast<uint32_t>(MeshFlags::OptimizeOverdraw)          |
+            static_cast<uint32_t>(MeshFlags::OptimizeVertexFetch)       |
+            static_cast<uint32_t>(MeshFlags::GenerateLods);
     }
 
     float Mesh::ComputeNormalizedScale()
@@ -227,43 +363,210 @@ namespace Spartan
     {
         SP_ASSERT(!m_indices.empty());
         SP_ASSERT(!m_vertices.empty());
+        SP_ASSERT_MSG(m_lods.empty(), "Lods have to be generated after optimizing, vertex fetch optimization reorders the vertices");
 
-        uint32_t index_count                     = static_cast<uint32_t>(m_indices.size());
-        uint32_t vertex_count                    = static_cast<uint32_t>(m_vertices.size());
-        size_t vertex_size                       = sizeof(RHI_Vertex_PosTexNorTan);
-        vector<uint32_t> indices                 = m_indices;
-        vector<RHI_Vertex_PosTexNorTan> vertices = m_vertices;
-
-        // vertex cache optimization
-        // improves the GPU's post-transform cache hit rate, reducing the required vertex shader invocations
-        if (m_flags & static_cast<uint32_t>(MeshFlags::OptimizeVertexCache))
+        // geometry which wasn't added through AddGeometry() is optimized as a single submesh
+        vector<MeshSubmesh> submeshes = m_submeshes;
+        if (submeshes.empty())
         {
-            meshopt_optimizeVertexCache(&indices[0], &m_indices[0], index_count, vertex_count);
+            submeshes.push_back({ 0, GetIndexCount(), 0, GetVertexCount() });
         }
 
-        // overdraw optimization
-        // minimizes overdraw by reordering triangles, aiming to reduce pixel shader invocations
-        if (m_flags & static_cast<uint32_t>(MeshFlags::OptimizeOverdraw))
+        // the statistics, before and after, summed over all the submeshes
+        struct statistics
+        {
+            uint64_t vertices_transformed = 0;
+            uint64_t bytes_fetched        = 0;
+        };
+        vector<statistics> statistics_before(submeshes.size());
+        vector<statistics> statistics_after(submeshes.size());
+
+        // each submesh has its own range of indices and vertices, so they can be optimized in parallel
+        const size_t vertex_size = sizeof(RHI_Vertex_PosTexNorTan);
+        auto optimize = [this, &submeshes, &statistics_before, &statistics_after, vertex_size](uint32_t submesh_start, uint32_t submesh_end)
         {
-            meshopt_optimizeOverdraw(&indices[0], &indices[0], index_count, &m_vertices[0].pos[0], vertex_count, vertex_size, 1.05f);
+            // the cache size the statistics are measured with, acmr is the vertices transformed per triangle
+            const uint32_t cache_size = 16;
+
+            for (uint32_t submesh_index = submesh_start; submesh_index < submesh_end; submesh_index++)
+            {
+                const MeshSubmesh& submesh        = submeshes[submesh_index];
+                uint32_t* indices                 = &m_indices[submesh.index_offset];
+                RHI_Vertex_PosTexNorTan* vertices = &m_vertices[submesh.vertex_offset];
+                const size_t index_count          = submesh.index_count;
+                const size_t vertex_count         = submesh.vertex_count;
+                if (index_count == 0 || vertex_count == 0)
+                    continue;
+
+                statistics_before[submesh_index].vertices_transformed = meshopt_analyzeVertexCache(indices, index_count, vertex_count, cache_size, 0, 0).vertices_transformed;
+                statistics_before[submesh_index].bytes_fetched        = meshopt_analyzeVertexFetch(indices, index_count, vertex_count, vertex_size).bytes_fetched;
+
+                vector<uint32_t> indices_optimized(indices, indices + index_count);
+
+                // vertex cache optimization
+                // improves the GPU's post-transform cache hit rate, reducing the required vertex shader invocations
+                if (m_flags & static_cast<uint32_t>(MeshFlags::OptimizeVertexCache))
+                {
+                    meshopt_optimizeVertexCache(indices_optimized.data(), indices, index_count, vertex_count);
+                }
+
+                // overdraw optimization
+                // minimizes overdraw by reordering triangles, aiming to reduce pixel shader invocations
+                if (m_flags & static_cast<uint32_t>(MeshFlags::OptimizeOverdraw))
+                {
+                    vector<uint32_t> indices_input = indices_optimized;
+                    meshopt_optimizeOverdraw(indices_optimized.data(), indices_input.data(), index_count, &vertices[0].pos[0], vertex_count, vertex_size, 1.05f);
+                }
+
+                // vertex fetch optimization
+                // reorders vertices and changes indices to improve vertex fetch cache performance, reducing the bandwidth needed to fetch vertices
+                if (m_flags & static_cast<uint32_t>(MeshFlags::OptimizeVertexFetch))
+                {
+                    // unused vertices end up at the end and keep their old values, the submesh's vertex count doesn't change
+                    vector<RHI_Vertex_PosTexNorTan> vertices_input(vertices, vertices + vertex_count);
+                    meshopt_optimizeVertexFetch(vertices, indices_optimized.data(), index_count, vertices_input.data(), vertex_count, vertex_size);
+                }
+
+                copy(indices_optimized.begin(), indices_optimized.end(), indices);
+
+                statistics_after[submesh_index].vertices_transformed = meshopt_analyzeVertexCache(indices, index_count, vertex_count, cache_size, 0, 0).vertices_transformed;
+                statistics_after[submesh_index].bytes_fetched        = meshopt_analyzeVertexFetch(indices, index_count, vertex_count, vertex_size).bytes_fetched;
+            }
+        };
+        ThreadPool::ParallelLoop(optimize, static_cast<uint32_t>(submeshes.size()));
+
+        // report
+        {
+            statistics before;
+            statistics after;
+            for (uint32_t i = 0; i < static_cast<uint32_t>(submeshes.size()); i++)
+            {
+                before.vertices_transformed += statistics_before[i].vertices_transformed;
+                before.bytes_fetched        += statistics_before[i].bytes_fetched;
+                after.vertices_transformed  += statistics_after[i].vertices_transformed;
+                after.bytes_fetched         += statistics_after[i].bytes_fetched;
+            }
+
+            const double triangle_count = static_cast<double>(m_indices.size() / 3);
+            const double vertex_bytes   = static_cast<double>(m_vertices.size() * vertex_size);
+            SP_LOG_INFO("Optimized \"%s\", acmr: %.3f -> %.3f, overfetch: %.3f -> %.3f",
+                m_object_name.c_str(),
+                before.vertices_transformed / triangle_count,
+                after.vertices_transformed  / triangle_count,
+                before.bytes_fetched / vertex_bytes,
+                after.bytes_fetched  / vertex_bytes
+            );
         }
+    }
+
+    void Mesh::GenerateLods()
+    {
+        m_lods.clear();
+        m_lod_indices.clear();
 
-        // vertex fetch optimization
-        // reorders vertices and changes indices to improve vertex fetch cache performance, reducing the bandwidth needed to fetch vertices
-        if (m_flags & static_cast<uint32_t>(MeshFlags::OptimizeVertexFetch))
+        if (m_submeshes.empty() || m_indices.empty() || m_vertices.empty())
+            return;
+
+        // simplify each submesh, in parallel, each one into its own list of indices
+        vector<vector<uint32_t>> submesh_lod_indices(m_submeshes.size());
+        m_lods.resize(m_submeshes.size() * (mesh_lod_count - 1));
+        auto simplify = [this, &submesh_lod_indices](uint32_t submesh_start, uint32_t submesh_end)
+        {
+            for (uint32_t submesh_index = submesh_start; submesh_index < submesh_end; submesh_index++)
+            {
+                const MeshSubmesh& submesh = m_submeshes[submesh_index];
+                vector<uint32_t>& lod_indices = submesh_lod_indices[submesh_index];
+
+                // each lod starts from the previous one, offsets are relative to this submesh's lod indices for now
+                MeshLod lod_previous              = { submesh.index_offset, submesh.index_count };
+                vector<uint32_t> indices_previous = vector<uint32_t>(m_indices.begin() + submesh.index_offset, m_indices.begin() + submesh.index_offset + submesh.index_count);
+                vector<uint32_t> indices_simplified(indices_previous.size());
+                for (uint32_t lod = 1; lod < mesh_lod_count; lod++)
+                {
+                    // the error is relative to the submesh's extents, and it's allowed to grow with each lod
+                    const size_t index_count_target = (indices_previous.size() / 6) * 3;
+                    const float error_target        = 0.01f * static_cast<float>(1 << (lod - 1));
+                    const size_t index_count        = meshopt_simplify(
+                        indices_simplified.data(),
+                        indices_previous.data(),
+                        indices_previous.size(),
+                        &m_vertices[submesh.vertex_offset].pos[0],
+                        submesh.vertex_count,
+                        sizeof(RHI_Vertex_PosTexNorTan),
+                        index_count_target,
+                        error_target
+                    );
+
+                    // if the simplifier can't remove enough without exceeding the error, the previous lod is used again
+                    MeshLod& mesh_lod = m_lods[submesh_index * (mesh_lod_count - 1) + lod - 1];
+                    if (index_count == 0 || index_count > (indices_previous.size() * 9) / 10)
+                    {
+                        mesh_lod = lod_previous;
+                        continue;
+                    }
+
+                    mesh_lod.index_offset = static_cast<uint32_t>(m_indices.size() + lod_indices.size()); // made absolute below
+                    mesh_lod.index_count  = static_cast<uint32_t>(index_count);
+                    lod_indices.insert(lod_indices.end(), indices_simplified.begin(), indices_simplified.begin() + index_count);
+
+                    indices_previous.assign(indices_simplified.begin(), indices_simplified.begin() + index_count);
+                    lod_previous = mesh_lod;
+                }
+            }
+        };
+        ThreadPool::ParallelLoop(simplify, static_cast<uint32_t>(m_submeshes.size()));
+
+        // concatenate them, lods which were simplified point past the mesh's indices and need the submeshes before them
+        for (uint32_t submesh_index = 0; submesh_index < static_cast<uint32_t>(m_submeshes.size()); submesh_index++)
         {
-            meshopt_optimizeVertexFetch(&m_vertices[0], &indices[0], index_count, &vertices[0], vertex_count, vertex_size);
+            const uint32_t base = static_cast<uint32_t>(m_lod_indices.size());
+            for (uint32_t lod = 0; lod < mesh_lod_count - 1; lod++)
+            {
+                MeshLod& mesh_lod = m_lods[submesh_index * (mesh_lod_count - 1) + lod];
+                if (mesh_lod.index_offset >= m_indices.size())
+                {
+                    mesh_lod.index_offset += base;
+                }
+            }
+
+            m_lod_indices.insert(m_lod_indices.end(), submesh_lod_indices[submesh_index].begin(), submesh_lod_indices[submesh_index].end());
         }
+    }
 
-        // store the updated indices back to m_indices
-        m_indices = indices;
+    MeshLod Mesh::GetLod(const uint32_t submesh_index_offset, const uint32_t submesh_index_count, const uint32_t lod) const
+    {
+        const MeshLod lod_zero = { submesh_index_offset, submesh_index_count };
+        if (lod == 0 || m_lods.empty())
+            return lod_zero;
+
+        // submeshes are stored back to back, so they are sorted by index offset
+        auto it = lower_bound(m_submeshes.begin(), m_submeshes.end(), submesh_index_offset, [](const MeshSubmesh& submesh, const uint32_t index_offset)
+        {
+            return submesh.index_offset < index_offset;
+        });
+
+        if (it == m_submeshes.end() || it->index_offset != submesh_index_offset || it->index_count != submesh_index_count)
+            return lod_zero;
+
+        const uint32_t submesh_index = static_cast<uint32_t>(distance(m_submeshes.begin(), it));
+        return m_lods[submesh_index * (mesh_lod_count - 1) + min(lod, mesh_lod_count - 1) - 1];
     }
 
     void Mesh::CreateGpuBuffers()
     {
         SP_ASSERT_MSG(!m_indices.empty(), "There are no indices");
         m_index_buffer = make_shared<RHI_IndexBuffer>(false, (string("mesh_index_buffer_") + m_object_name).c_str());
-        m_index_buffer->Create(m_indices);
+        if (m_lod_indices.empty())
+        {
+            m_index_buffer->Create(m_indices);
+        }
+        else
+        {
+            // the lod indices come after the mesh's indices
+            vector<uint32_t> indices = m_indices;
+            indices.insert(indices.end(), m_lod_indices.begin(), m_lod_indices.end());
+            m_index_buffer->Create(indices);
+        }
 
         SP_ASSERT_MSG(!m_vertices.empty(), "There are no vertices");
         m_vertex_buffer = make_shared<RHI_VertexBuffer>(false, (string("mesh_vertex_buffer_") + m_object_name).c_str());
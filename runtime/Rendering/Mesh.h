@@ -40,6 +40,26 @@ namespace Spartan
         OptimizeVertexCache       = 1 << 4,
         OptimizeVertexFetch       = 1 << 5,
         OptimizeOverdraw          = 1 << 6,
+        GenerateLods              = 1 << 7,
+    };
+
+    // a range of the mesh's geometry, indices are relative to the vertex offset
+    struct MeshSubmesh
+    {
+        uint32_t index_offset  = 0;
+        uint32_t index_count   = 0;
+        uint32_t vertex_offset = 0;
+        uint32_t vertex_count  = 0;
+    };
+
+    // lod 0 is the submesh itself, each next lod is a simplification of the previous one, with about half the triangles
+    const uint32_t mesh_lod_count = 4;
+
+    // a range of the index buffer, lod indices are stored after the mesh's indices and are relative to the submesh's vertex offset
+    struct MeshLod
+    {
+        uint32_t index_offset = 0;
+        uint32_t index_count  = 0;
     };
 
     class Mesh : public IResource
@@ -67,6 +87,16 @@ namespace Spartan
         // Add geometry
         void AddVertices(const std::vector<RHI_Vertex_PosTexNorTan>& vertices, uint32_t* vertex_offset_out = nullptr);
         void AddIndices(const std::vector<uint32_t>& indices, uint32_t* index_offset_out = nullptr);
+        void AddGeometry(const std::vector<RHI_Vertex_PosTexNorTan>& vertices, const std::vector<uint32_t>& indices, uint32_t* vertex_offset_out = nullptr, uint32_t* index_offset_out = nullptr);
+
+        // Submeshes, recorded by AddGeometry(), each one can also be loaded on its own
+        const std::vector<MeshSubmesh>& GetSubmeshes() const { return m_submeshes; }
+        static bool LoadSubmeshFromFile(const std::string& file_path, uint32_t submesh_index, std::vector<uint32_t>* indices, std::vector<RHI_Vertex_PosTexNorTan>* vertices);
+
+        // Lods, generated per submesh, a submesh is identified by its index offset
+        void GenerateLods();
+        bool HasLods() const { return !m_lods.empty(); }
+        MeshLod GetLod(uint32_t submesh_index_offset, uint32_t submesh_index_count, uint32_t lod) const;
 
         // Get geometry
         std::vector<RHI_Vertex_PosTexNorTan>& GetVertices() { return m_vertices; }
@@ -101,6 +131,9 @@ namespace Spartan
         // Geometry
         std::vector<RHI_Vertex_PosTexNorTan> m_vertices;
         std::vector<uint32_t> m_indices;
+        std::vector<MeshSubmesh> m_submeshes;
+        std::vector<MeshLod> m_lods; // mesh_lod_count - 1 per submesh, lod 0 isn't stored
+        std::vector<uint32_t> m_lod_indices;
 
         // GPU buffers
         std::shared_ptr<RHI_VertexBuffer> m_vertex_buffer;
@@ -54,6 +54,7 @@ namespace Spartan
     Cb_Light Renderer::m_cb_light_cpu;
     Cb_Material Renderer::m_cb_material_cpu;
     shared_ptr<RHI_VertexBuffer> Renderer::m_vertex_buffer_lines;
+    array<shared_ptr<RHI_VertexBuffer>, 3> Renderer::m_vertex_buffers_instances;
     vector<RHI_Vertex_PosCol> Renderer::m_line_vertices;
     vector<float> Renderer::m_lines_duration;
     uint32_t Renderer::m_lines_index_depth_off;
@@ -85,40 +86,16 @@ namespace Spartan
         unordered_map<Renderer_Option, float> m_options;
         mutex mutex_entity_addition;
         vector<shared_ptr<Entity>> m_entities_to_add;
+        bool m_entities_to_add_pending = false;
+        vector<WorldChange> m_entity_changes;
+        // the position of each entity within each bucket of m_renderables, so that entities can be removed in O(1)
+        unordered_map<Renderer_Entity, unordered_map<const Entity*, uint32_t>> m_renderable_indices;
         uint64_t frame_num                       = 0;
         Math::Vector2 jitter_offset              = Math::Vector2::Zero;
         const uint32_t resolution_shadow_min     = 128;
         float near_plane                         = 0.0f;
         float far_plane                          = 1.0f;
         bool dirty_orthographic_projection       = true;
-
-        void sort_renderables(Camera* camera, vector<shared_ptr<Entity>>* renderables, const bool are_transparent)
-        {
-            if (!camera || renderables->size() <= 2)
-                return;
-
-            auto comparison_op = [camera](shared_ptr<Entity> entity)
-            {
-                auto renderable = entity->GetComponent<Renderable>();
-                if (!renderable)
-                    return 0.0f;
-
-                return (renderable->GetBoundingBox().GetCenter() - camera->GetTransform()->GetPosition()).LengthSquared();
-            };
-
-            // sort by depth
-            sort(renderables->begin(), renderables->end(), [&comparison_op, &are_transparent](shared_ptr<Entity> a, shared_ptr<Entity> b)
-            {
-                if (are_transparent)
-                {
-                    return comparison_op(a) > comparison_op(b); // back-to-front for transparent
-                }
-                else
-                {
-                    return comparison_op(a) < comparison_op(b); // front-to-back for opaque
-                }
-            });
-        }
     }
 
     void Renderer::Initialize()
@@ -217,6 +194,7 @@ namespace Spartan
         {
             // subscribe
             SP_SUBSCRIBE_TO_EVENT(EventType::WorldResolved,           SP_EVENT_HANDLER_VARIANT_STATIC(OnWorldResolved));
+            SP_SUBSCRIBE_TO_EVENT(EventType::WorldChanged,            SP_EVENT_HANDLER_VARIANT_STATIC(OnWorldChanged));
             SP_SUBSCRIBE_TO_EVENT(EventType::WorldClear,              SP_EVENT_HANDLER_STATIC(OnClear));
             SP_SUBSCRIBE_TO_EVENT(EventType::WindowFullScreenToggled, SP_EVENT_HANDLER_STATIC(OnFullScreenToggled));
 
@@ -234,9 +212,12 @@ namespace Spartan
             DestroyResources();
 
             m_entities_to_add.clear();
+            m_entity_changes.clear();
             m_renderables.clear();
+            m_renderable_indices.clear();
             swap_chain            = nullptr;
             m_vertex_buffer_lines = nullptr;
+            m_vertex_buffers_instances.fill(nullptr);
         }
 
         RenderDoc::Shutdown();
@@ -575,12 +556,14 @@ namespace Spartan
         // this ensures that if any entities are deallocated by the world.
         // we'll still have some valid pointers until the are overridden by m_renderables_world.
 
-        vector<shared_ptr<Entity>> entities = get<vector<shared_ptr<Entity>>>(data);
+        const vector<shared_ptr<Entity>>& entities = get<vector<shared_ptr<Entity>>>(data);
 
         lock_guard lock(mutex_entity_addition);
         m_entities_to_add.clear();
+        m_entity_changes.clear(); // superseded
+        m_entities_to_add_pending = true;
 
-        for (shared_ptr<Entity> entity : entities)
+        for (const shared_ptr<Entity>& entity : entities)
         {
             SP_ASSERT_MSG(entity != nullptr, "Entity is null");
 
@@ -591,9 +574,98 @@ namespace Spartan
         }
     }
 
+    void Renderer::OnWorldChanged(sp_variant data)
+    {
+        vector<WorldChange>& changes = get<vector<WorldChange>>(data);
+
+        lock_guard lock(mutex_entity_addition);
+        m_entity_changes.insert(m_entity_changes.end(), make_move_iterator(changes.begin()), make_move_iterator(changes.end()));
+    }
+
+    void Renderer::RenderablesAdd(const shared_ptr<Entity>& entity)
+    {
+        auto add = [&entity](const Renderer_Entity type)
+        {
+            vector<shared_ptr<Entity>>& bucket = m_renderables[type];
+            m_renderable_indices[type][entity.get()] = static_cast<uint32_t>(bucket.size());
+            bucket.emplace_back(entity);
+        };
+
+        if (shared_ptr<Renderable> renderable = entity->GetComponent<Renderable>())
+        {
+            bool is_transparent = false;
+            bool is_visible     = true;
+
+            if (const Material* material = renderable->GetMaterial())
+            {
+                is_transparent = material->GetProperty(MaterialProperty::ColorA) < 1.0f;
+                is_visible     = material->GetProperty(MaterialProperty::ColorA) != 0.0f;
+            }
+
+            if (is_visible)
+            {
+                if (is_transparent)
+                {
+                    add(renderable->HasInstancing() ? Renderer_Entity::GeometryTransparentInstanced : Renderer_Entity::GeometryTransparent);
+                }
+                else
+                {
+                    add(renderable->HasInstancing() ? Renderer_Entity::GeometryInstanced : Renderer_Entity::Geometry);
+                }
+            }
+        }
+
+        if (shared_ptr<Light> light = entity->GetComponent<Light>())
+        {
+            add(Renderer_Entity::Light);
+        }
+
+        if (shared_ptr<Camera> camera = entity->GetComponent<Camera>())
+        {
+            add(Renderer_Entity::Camera);
+            m_camera = camera;
+        }
+
+        if (shared_ptr<ReflectionProbe> reflection_probe = entity->GetComponent<ReflectionProbe>())
+        {
+            add(Renderer_Entity::ReflectionProbe);
+        }
+
+        if (shared_ptr<AudioSource> audio_source = entity->GetComponent<AudioSource>())
+        {
+            add(Renderer_Entity::AudioSource);
+        }
+    }
+
+    void Renderer::RenderablesRemove(const Entity* entity)
+    {
+        for (auto& it : m_renderable_indices)
+        {
+            unordered_map<const Entity*, uint32_t>& indices = it.second;
+
+            auto it_index = indices.find(entity);
+            if (it_index == indices.end())
+                continue;
+
+            // swap with the last and pop
+            vector<shared_ptr<Entity>>& bucket = m_renderables[it.first];
+            const uint32_t index = it_index->second;
+            if (index != bucket.size() - 1)
+            {
+                bucket[index]                = move(bucket.back());
+                indices[bucket[index].get()] = index;
+            }
+            bucket.pop_back();
+            indices.erase(entity);
+        }
+    }
+
     void Renderer::OnClear()
     {
+        lock_guard lock(mutex_entity_addition);
         m_renderables.clear();
+        m_renderable_indices.clear();
+        m_entity_changes.clear();
     }
 
     void Renderer::OnFullScreenToggled()
@@ -628,67 +700,52 @@ namespace Spartan
     void Renderer::OnFrameStart(RHI_CommandList* cmd_list)
     {
         // acquire renderables
-        if (!m_entities_to_add.empty())
         {
-            // clear previous state
-            m_renderables.clear();
-            m_camera = nullptr;
+            lock_guard lock(mutex_entity_addition);
 
-            for (shared_ptr<Entity> entity : m_entities_to_add)
+            if (m_entities_to_add_pending)
             {
-                if (shared_ptr<Renderable> renderable = entity->GetComponent<Renderable>())
-                {
-                    bool is_transparent = false;
-                    bool is_visible     = true;
-
-                    if (const Material* material = renderable->GetMaterial())
-                    {
-                        is_transparent = material->GetProperty(MaterialProperty::ColorA) < 1.0f;
-                        is_visible     = material->GetProperty(MaterialProperty::ColorA) != 0.0f;
-                    }
-
-                    if (is_visible)
-                    {
-                        if (is_transparent)
-                        {
-                            m_renderables[renderable->HasInstancing() ? Renderer_Entity::GeometryTransparentInstanced : Renderer_Entity::GeometryTransparent].emplace_back(entity);
-                        }
-                        else
-                        {
-                            m_renderables[renderable->HasInstancing() ? Renderer_Entity::GeometryInstanced : Renderer_Entity::Geometry].emplace_back(entity);
-                        }
-                    }
-                }
+                // full resolve, clear previous state
+                m_renderables.clear();
+                m_renderable_indices.clear();
+                m_camera = nullptr;
 
-                if (shared_ptr<Light> light = entity->GetComponent<Light>())
+                // the draw order is decided every frame, see Visibility_OnFrameStart()
+                for (const shared_ptr<Entity>& entity : m_entities_to_add)
                 {
-                    m_renderables[Renderer_Entity::Light].emplace_back(entity);
+                    RenderablesAdd(entity);
                 }
 
-                if (shared_ptr<Camera> camera = entity->GetComponent<Camera>())
+                m_entities_to_add.clear();
+                m_entities_to_add_pending = false;
+            }
+            else if (!m_entity_changes.empty())
+            {
+                // incremental, only the changed entities are (re-)bucketed
+                for (const WorldChange& change : m_entity_changes)
                 {
-                    m_renderables[Renderer_Entity::Camera].emplace_back(entity);
-                    m_camera = camera;
-                }
+                    RenderablesRemove(change.entity.get());
 
-                if (shared_ptr<ReflectionProbe> reflection_probe = entity->GetComponent<ReflectionProbe>())
-                {
-                    m_renderables[Renderer_Entity::ReflectionProbe].emplace_back(entity);
+                    if (change.type != WorldChangeType::Removed && change.entity->IsActiveRecursively())
+                    {
+                        RenderablesAdd(change.entity);
+                    }
                 }
 
-                if (shared_ptr<AudioSource> audio_source = entity->GetComponent<AudioSource>())
+                // the camera might have been removed
+                if (m_camera && !m_renderable_indices[Renderer_Entity::Camera].count(m_camera->GetEntityPtr()))
                 {
-                    m_renderables[Renderer_Entity::AudioSource].emplace_back(entity);
+                    const vector<shared_ptr<Entity>>& cameras = m_renderables[Renderer_Entity::Camera];
+                    m_camera = cameras.empty() ? nullptr : cameras.back()->GetComponent<Camera>();
                 }
-            }
 
-            // sort them by distance
-            sort_renderables(m_camera.get(), &m_renderables[Renderer_Entity::Geometry], false);
-            sort_renderables(m_camera.get(), &m_renderables[Renderer_Entity::GeometryTransparent], true);
-
-            m_entities_to_add.clear();
+                m_entity_changes.clear();
+            }
         }
 
+        // cull, once for all the passes
+        Visibility_OnFrameStart();
+
         // generate mips
         {
             lock_guard lock(mutex_mip_generation);
@@ -39,8 +39,10 @@ namespace Spartan
 {
     //= FWD DECLARATIONS =
     class Entity;
+    class Component;
     class Camera;
     class Light;
+    class Renderable;
     namespace Math
     {
         class BoundingBox;
@@ -48,6 +50,19 @@ namespace Spartan
     }
     //====================
 
+    // a draw of a renderable, as culled and sorted for a view, see Renderer_Visibility.cpp
+    struct Renderer_DrawCall
+    {
+        Entity* entity                    = nullptr; // for batches, the first of the batched entities
+        Renderable* renderable            = nullptr; // the entity's, so that the passes don't have to look it up per draw
+        RHI_VertexBuffer* instance_buffer = nullptr; // instanced draws only
+        uint32_t instance_start           = 0;
+        uint32_t instance_count           = 1;
+        uint32_t index_offset             = 0;       // the range of the lod that's drawn
+        uint32_t index_count              = 0;
+        bool is_batch                     = false;   // the instances are full world transforms, so the pass transform is the identity
+    };
+
     class SP_CLASS Renderer
     {
     public:
@@ -190,6 +205,11 @@ namespace Spartan
 
         // event handlers
         static void OnWorldResolved(sp_variant data);
+        static void OnWorldChanged(sp_variant data);
+
+        // renderables
+        static void RenderablesAdd(const std::shared_ptr<Entity>& entity);
+        static void RenderablesRemove(const Entity* entity);
         static void OnClear();
         static void OnFullScreenToggled();
 
@@ -197,6 +217,10 @@ namespace Spartan
         static void Lines_OneFrameStart();
         static void Lines_OnFrameEnd();
 
+        // visibility, culled and sorted once per frame for every view (camera, light cascade/face, probe face)
+        static void Visibility_OnFrameStart();
+        static const std::vector<Renderer_DrawCall>& Visibility_Get(const Component* view, uint32_t view_index, Renderer_Entity type);
+
         // frame
         static void OnFrameStart(RHI_CommandList* cmd_list);
         static void OnFrameEnd(RHI_CommandList* cmd_list);
@@ -215,6 +239,7 @@ namespace Spartan
         static Cb_Light m_cb_light_cpu;
         static Cb_Material m_cb_material_cpu;
         static std::shared_ptr<RHI_VertexBuffer> m_vertex_buffer_lines;
+        static std::array<std::shared_ptr<RHI_VertexBuffer>, 3> m_vertex_buffers_instances;
         static bool m_brdf_specular_lut_rendered;
         static std::vector<RHI_Vertex_PosCol> m_line_vertices;
         static std::vector<float> m_lines_duration;
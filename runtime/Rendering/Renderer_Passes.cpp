@@ -183,9 +183,8 @@ namespace Spartan
         uint32_t end_index   = !is_transparent_pass ? 2 : 4;
         for (uint32_t i = start_index; i < end_index; i++)
         {
-            // acquire entities
-            auto& entities = m_renderables[static_cast<Renderer_Entity>(i)];
-            if (entities.empty())
+            // acquire entities, plain geometry can also be batched into the instanced bucket
+            if (m_renderables[static_cast<Renderer_Entity>(i)].empty() && (i != 1 || m_renderables[Renderer_Entity::Geometry].empty()))
                 continue;
 
             // go through all of the lights
@@ -252,18 +251,16 @@ namespace Spartan
                         UpdateConstantBufferLight(cmd_list, light);
                     }
 
-                    // go through all of the entities
-                    for (shared_ptr<Entity> entity : entities)
+                    // go through the shadow casters that this cascade/face can see, they are sorted by material
+                    uint64_t bound_material_id = 0;
+                    for (const Renderer_DrawCall& draw : Visibility_Get(light.get(), array_index, static_cast<Renderer_Entity>(i)))
                     {
                         // acquire renderable component
-                        shared_ptr<Renderable> renderable = entity->GetComponent<Renderable>();
-                        Mesh* mesh         = renderable->GetMesh();
-                        Material* material = renderable->GetMaterial();
-                        if (!renderable || !renderable->GetCastShadows() || !mesh || !material)
-                            continue;
-
-                        // skip objects outside of the view frustum
-                        if (!light->IsInViewFrustum(renderable, array_index))
+                        Entity* entity         = draw.entity;
+                        Renderable* renderable = draw.renderable;
+                        Mesh* mesh             = renderable->GetMesh();
+                        Material* material     = renderable->GetMaterial();
+                        if (!mesh || !material)
                             continue;
 
                         // set vertex, index and instance buffers
@@ -271,16 +268,18 @@ namespace Spartan
                             cmd_list->SetBufferVertex(mesh->GetVertexBuffer());
                             if (pso.instancing)
                             {
-                                cmd_list->SetBufferVertex(renderable->GetInstanceBuffer(), 1);
+                                cmd_list->SetBufferVertex(draw.instance_buffer, 1);
                             }
 
                             cmd_list->SetBufferIndex(mesh->GetIndexBuffer());
                         }
 
                         // set material
+                        if (bound_material_id != material->GetObjectId())
                         {
                             SetTexturesMaterial(cmd_list, material);
                             UpdateConstantBufferMaterial(cmd_list, material);
+                            bound_material_id = material->GetObjectId();
                         }
 
                         // set pass constants
@@ -291,16 +290,17 @@ namespace Spartan
                                 material->GetProperty(MaterialProperty::ColorA)
                             );
                             m_cb_pass_cpu.set_f3_value2(static_cast<float>(array_index), 0.0f, 0.0f);
-                            m_cb_pass_cpu.transform = entity->GetTransform()->GetMatrix();
+                            m_cb_pass_cpu.transform = draw.is_batch ? Matrix::Identity : entity->GetTransform()->GetMatrix();
                             PushPassConstants(cmd_list);
                         }
 
                         // draw
                         cmd_list->DrawIndexed(
-                            renderable->GetIndexCount(),
-                            renderable->GetIndexOffset(),
+                            draw.index_count,
+                            draw.index_offset,
                             renderable->GetVertexOffset(),
-                            pso.instancing ? renderable->GetInstanceCount() : 1
+                            draw.instance_count,
+                            draw.instance_start
                         );
                     }
                 }
@@ -370,10 +370,10 @@ namespace Spartan
                 // compute view projection matrix
                 Matrix view_projection = probe->GetViewMatrix(face_index) * probe->GetProjectionMatrix();
 
-                // for each renderable entity
-                for (uint32_t index_renderable = 0; index_renderable < static_cast<uint32_t>(renderables.size()); index_renderable++)
+                // for each renderable entity that this face can see
+                for (const Renderer_DrawCall& draw : Visibility_Get(probe.get(), face_index, Renderer_Entity::Geometry))
                 {
-                    shared_ptr<Entity> entity = renderables[index_renderable];
+                    Entity* entity = draw.entity;
 
                     // for each light entity
                     for (uint32_t index_light = 0; index_light < static_cast<uint32_t>(lights.size()); index_light++)
@@ -383,7 +383,7 @@ namespace Spartan
                             if (light->GetIntensityWatt(GetCamera().get()) != 0)
                             {
                                 // get renderable
-                                shared_ptr<Renderable> renderable = entity->GetComponent<Renderable>();
+                                Renderable* renderable = draw.renderable;
                                 if (!renderable)
                                     continue;
 
@@ -397,10 +397,6 @@ namespace Spartan
                                 if (!mesh || !mesh->GetVertexBuffer() || !mesh->GetIndexBuffer())
                                     continue;
 
-                                // skip objects outside of the view frustum
-                                if (!probe->IsInViewFrustum(renderable, face_index))
-                                    continue;
-
                                 // set geometry (will only happen if not already set)
                                 cmd_list->SetBufferIndex(mesh->GetIndexBuffer());
                                 cmd_list->SetBufferVertex(mesh->GetVertexBuffer());
@@ -415,7 +411,7 @@ namespace Spartan
                                 // update light buffer
                                 UpdateConstantBufferLight(cmd_list, light);
 
-                                cmd_list->DrawIndexed(renderable->GetIndexCount(), renderable->GetIndexOffset(), renderable->GetVertexOffset());
+                                cmd_list->DrawIndexed(draw.index_count, draw.index_offset, renderable->GetVertexOffset());
                             }
                         }
                     }
@@ -442,9 +438,8 @@ namespace Spartan
         bool is_first_pass   = true;
         for (uint32_t i = start_index; i < end_index; i++)
         {
-            // acquire entities
-            auto& entities = m_renderables[static_cast<Renderer_Entity>(i)];
-            if (entities.empty())
+            // acquire entities, plain geometry can also be batched into the instanced bucket
+            if (m_renderables[static_cast<Renderer_Entity>(i)].empty() && (i != 1 || m_renderables[Renderer_Entity::Geometry].empty()))
                 continue;
 
             // define pipeline state
@@ -464,10 +459,11 @@ namespace Spartan
             cmd_list->SetPipelineState(pso);
 
             uint64_t bound_material_id = 0;
-            for (shared_ptr<Entity> entity : entities)
+            for (const Renderer_DrawCall& draw : Visibility_Get(GetCamera().get(), 0, static_cast<Renderer_Entity>(i)))
             {
                 // get renderable
-                shared_ptr<Renderable> renderable = entity->GetComponent<Renderable>();
+                Entity* entity         = draw.entity;
+                Renderable* renderable = draw.renderable;
                 if (!renderable)
                     continue;
 
@@ -476,10 +472,6 @@ namespace Spartan
                 if (!material)
                     continue;
 
-                // skip objects outside of the view frustum
-                if (!GetCamera()->IsInViewFrustum(renderable))
-                    continue;
-
                 // mesh can be null when async loading
                 Mesh* mesh = renderable->GetMesh();
                 if (!mesh)
@@ -490,7 +482,7 @@ namespace Spartan
                     cmd_list->SetBufferVertex(mesh->GetVertexBuffer());
                     if (pso.instancing)
                     {
-                        cmd_list->SetBufferVertex(renderable->GetInstanceBuffer(), 1);
+                        cmd_list->SetBufferVertex(draw.instance_buffer, 1);
                     }
 
                     cmd_list->SetBufferIndex(mesh->GetIndexBuffer());
@@ -506,7 +498,7 @@ namespace Spartan
 
                 // set pass constants
                 {
-                    m_cb_pass_cpu.transform = entity->GetTransform()->GetMatrix();
+                    m_cb_pass_cpu.transform = draw.is_batch ? Matrix::Identity : entity->GetTransform()->GetMatrix();
                     m_cb_pass_cpu.set_f3_value(
                         material->HasTexture(MaterialTexture::AlphaMask) ? 1.0f : 0.0f,
                         material->HasTexture(MaterialTexture::Color)     ? 1.0f : 0.0f,
@@ -518,10 +510,11 @@ namespace Spartan
 
                 // draw
                 cmd_list->DrawIndexed(
-                    renderable->GetIndexCount(),
-                    renderable->GetIndexOffset(),
+                    draw.index_count,
+                    draw.index_offset,
                     renderable->GetVertexOffset(),
-                    pso.instancing ? renderable->GetInstanceCount() : 1
+                    draw.instance_count,
+                    draw.instance_start
                 );
             }
         }
@@ -561,9 +554,8 @@ namespace Spartan
         bool is_first_pass   = true;
         for (uint32_t i = start_index; i < end_index; i++)
         {
-            // acquire entities
-            auto& entities = m_renderables[static_cast<Renderer_Entity>(i)];
-            if (entities.empty())
+            // acquire entities, plain geometry can also be batched into the instanced bucket
+            if (m_renderables[static_cast<Renderer_Entity>(i)].empty() && (i != 1 || m_renderables[Renderer_Entity::Geometry].empty()))
                 continue;
 
             // note: if is_transparent_pass is true we could simply clear the RTs, however we don't do this as fsr
@@ -596,17 +588,14 @@ namespace Spartan
             cmd_list->SetPipelineState(pso);
 
             uint64_t bound_material_id = 0;
-            for (shared_ptr<Entity> entity : entities)
+            for (const Renderer_DrawCall& draw : Visibility_Get(GetCamera().get(), 0, static_cast<Renderer_Entity>(i)))
             {
                 // get renderable
-                shared_ptr<Renderable> renderable = entity->GetComponent<Renderable>();
+                Entity* entity         = draw.entity;
+                Renderable* renderable = draw.renderable;
                 if (!renderable)
                     continue;
 
-                // skip objects outside of the view frustum
-                if (!GetCamera()->IsInViewFrustum(renderable))
-                    continue;
-
                 // mesh can be null when async loading
                 Mesh* mesh = renderable->GetMesh();
                 if (!mesh)
@@ -617,7 +606,7 @@ namespace Spartan
                     cmd_list->SetBufferVertex(mesh->GetVertexBuffer());
                     if (pso.instancing)
                     {
-                        cmd_list->SetBufferVertex(renderable->GetInstanceBuffer(), 1);
+                        cmd_list->SetBufferVertex(draw.instance_buffer, 1);
                     }
 
                     cmd_list->SetBufferIndex(mesh->GetIndexBuffer());
@@ -638,20 +627,29 @@ namespace Spartan
                 {
                     m_cb_pass_cpu.set_is_transparent(is_transparent_pass);
 
-                    // update transform
-                    m_cb_pass_cpu.transform = entity->GetTransform()->GetMatrix();
-                    m_cb_pass_cpu.set_transform_previous(entity->GetTransform()->GetMatrixPrevious());
-                    entity->GetTransform()->SetMatrixPrevious(m_cb_pass_cpu.transform);
+                    // update transform, batches are static so their previous transforms are their current ones
+                    if (draw.is_batch)
+                    {
+                        m_cb_pass_cpu.transform = Matrix::Identity;
+                        m_cb_pass_cpu.set_transform_previous(Matrix::Identity);
+                    }
+                    else
+                    {
+                        m_cb_pass_cpu.transform = entity->GetTransform()->GetMatrix();
+                        m_cb_pass_cpu.set_transform_previous(entity->GetTransform()->GetMatrixPrevious());
+                        entity->GetTransform()->SetMatrixPrevious(m_cb_pass_cpu.transform);
+                    }
 
                     PushPassConstants(cmd_list);
                 }
 
                 // draw
                 cmd_list->DrawIndexed(
-                    renderable->GetIndexCount(),
-                    renderable->GetIndexOffset(),
+                    draw.index_count,
+                    draw.index_offset,
                     renderable->GetVertexOffset(),
-                    pso.instancing ? renderable->GetInstanceCount() : 1
+                    draw.instance_count,
+                    draw.instance_start
                 );
 
                 is_first_pass = false;
@@ -0,0 +1,685 @@
+/*
+Copyright(c) 2016-2023 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+//= INCLUDES ==============================
+#include "pch.h"
+#include <bit>
+#include "Renderer.h"
+#include "Mesh.h"
+#include "../Core/ThreadPool.h"
+#include "../Profiling/Profiler.h"
+#include "../World/Entity.h"
+#include "../World/Components/Camera.h"
+#include "../World/Components/Light.h"
+#include "../World/Components/ReflectionProbe.h"
+#include "../World/Components/Renderable.h"
+#include "../World/Components/Transform.h"
+#include "../RHI/RHI_Texture.h"
+#include "../RHI/RHI_VertexBuffer.h"
+//=========================================
+
+//= NAMESPACES ===============
+using namespace std;
+using namespace Spartan::Math;
+//============================
+
+namespace Spartan
+{
+    namespace
+    {
+        // the geometry buckets, Geometry to GeometryTransparentInstanced
+        const uint32_t bucket_count = 4;
+
+        // directional light cascades, point light faces and probe faces
+        const uint32_t view_index_count = 6;
+
+        // Visible renderables are drawn in the order of a 64-bit key, so that renderables which share state are
+        // drawn back to back. The bucket (pass and pipeline) is at the top, then, for opaque buckets, the material,
+        // the mesh and the depth (front-to-back), and for transparent buckets, the depth (back-to-front), the
+        // material and the mesh. Materials and meshes are keyed by a per-frame index, see draw_state().
+        const uint32_t key_bits_depth = 30;
+        const uint64_t key_mask_depth = (uint64_t(1) << key_bits_depth) - 1;
+
+        struct draw_packet
+        {
+            uint64_t key   = 0;
+            uint32_t index = 0; // into the bucket
+        };
+
+        // maps a float to an integer with the same order (negative values included), keeping the top bits
+        uint64_t key_depth(const float depth)
+        {
+            const uint32_t bits    = bit_cast<uint32_t>(depth);
+            const uint32_t ordered = (bits & 0x80000000) ? ~bits : (bits | 0x80000000);
+            return static_cast<uint64_t>(ordered >> (32 - key_bits_depth));
+        }
+
+        uint64_t key_make(const uint32_t bucket, const uint32_t state, const float depth)
+        {
+            const bool is_transparent = bucket >= 2;
+            const uint64_t depth_bits = key_depth(depth);
+
+            return (static_cast<uint64_t>(bucket) << 62) | (is_transparent ?
+                (((key_mask_depth - depth_bits) << 32) | state) :
+                ((static_cast<uint64_t>(state) << key_bits_depth) | depth_bits));
+        }
+
+        // lsd radix sort, 8 bits per pass, the passes where all the keys share a byte are skipped
+        void radix_sort(vector<draw_packet>& packets, vector<draw_packet>& scratch)
+        {
+            const uint32_t count = static_cast<uint32_t>(packets.size());
+            if (count <= 1)
+                return;
+
+            scratch.resize(count);
+            for (uint32_t shift = 0; shift < 64; shift += 8)
+            {
+                array<uint32_t, 256> histogram = {};
+                for (const draw_packet& packet : packets)
+                {
+                    histogram[(packet.key >> shift) & 0xFF]++;
+                }
+
+                if (histogram[(packets[0].key >> shift) & 0xFF] == count)
+                    continue;
+
+                uint32_t offset = 0;
+                for (uint32_t& bin : histogram)
+                {
+                    const uint32_t bin_count = bin;
+                    bin                      = offset;
+                    offset                  += bin_count;
+                }
+
+                for (const draw_packet& packet : packets)
+                {
+                    scratch[histogram[(packet.key >> shift) & 0xFF]++] = packet;
+                }
+
+                packets.swap(scratch);
+            }
+        }
+
+        // Bounding boxes are gathered once per frame, renderables update theirs lazily so views can't read them
+        // concurrently, and most renderables are tested against more than one view. They are stored as one array
+        // per component, so that frustums can test them in batches.
+        struct box_arrays
+        {
+            vector<float> center_x;
+            vector<float> center_y;
+            vector<float> center_z;
+            vector<float> extent_x;
+            vector<float> extent_y;
+            vector<float> extent_z;
+
+            void resize(const size_t count)
+            {
+                center_x.resize(count);
+                center_y.resize(count);
+                center_z.resize(count);
+                extent_x.resize(count);
+                extent_y.resize(count);
+                extent_z.resize(count);
+            }
+
+            void set(const uint32_t i, const BoundingBox& box)
+            {
+                const Vector3 center  = box.GetCenter();
+                const Vector3 extents = box.GetExtents();
+                center_x[i]           = center.x;
+                center_y[i]           = center.y;
+                center_z[i]           = center.z;
+                extent_x[i]           = extents.x;
+                extent_y[i]           = extents.y;
+                extent_z[i]           = extents.z;
+            }
+
+            FrustumBoxes get(const uint32_t offset, const uint32_t count) const
+            {
+                return { center_x.data() + offset, center_y.data() + offset, center_z.data() + offset, extent_x.data() + offset, extent_y.data() + offset, extent_z.data() + offset, count };
+            }
+        };
+
+        struct bucket_boxes
+        {
+            box_arrays bounds;
+            vector<Renderable*> renderables; // looked up once, getting the component copies a shared pointer
+            vector<uint8_t> casts_shadows;
+            vector<uint32_t> state;    // material and geometry indices, 16 bits each
+            vector<uint8_t> batchable; // batch_flag_* bits
+            vector<uint8_t> lod;
+
+            // instanced buckets only, the instances of renderable i are at instance_offsets[i] to instance_offsets[i + 1]
+            box_arrays instance_bounds;
+            vector<uint32_t> instance_offsets;
+
+            void resize(const size_t count)
+            {
+                bounds.resize(count);
+                renderables.resize(count);
+                casts_shadows.resize(count);
+                state.resize(count);
+                batchable.resize(count);
+                lod.resize(count);
+                instance_offsets.assign(count + 1, 0);
+            }
+
+            FrustumBoxes get() const
+            {
+                return bounds.get(0, static_cast<uint32_t>(casts_shadows.size()));
+            }
+
+            FrustumBoxes get_instances(const uint32_t i) const
+            {
+                return instance_bounds.get(instance_offsets[i], instance_offsets[i + 1] - instance_offsets[i]);
+            }
+        };
+        static array<bucket_boxes, bucket_count> boxes;
+
+        // Plain (non-instanced) opaque draws which share geometry and material are merged into one instanced draw,
+        // which goes into the instanced bucket. Their transforms are written to a per-frame instance buffer.
+        const uint8_t batch_flag_shadow = 1 << 0; // no vertex animation, which the instanced shaders would apply
+        const uint8_t batch_flag_static = 1 << 1; // the transform didn't change since the last frame, so velocity is just the camera's
+        const uint32_t batch_size_min   = 2;
+
+        struct view_visibility
+        {
+            array<array<vector<Renderer_DrawCall>, bucket_count>, view_index_count> visible;
+            array<vector<Renderer_DrawCall>, view_index_count> batches; // instance_start indexes into batched, until uploaded
+            array<vector<uint32_t>, view_index_count> batched; // indices into the bucket
+            array<array<vector<uint32_t>, bucket_count>, view_index_count> instances; // visible instances, instance_start indexes into them, until uploaded
+            uint64_t frame = 0; // views which weren't seen this frame are dropped
+        };
+        static unordered_map<const Component*, view_visibility> views;
+        static uint64_t frame = 0;
+
+        struct view_task
+        {
+            const Frustum* frustum            = nullptr;
+            bool ignore_near_plane            = false; // directional lights keep casters behind the near plane
+            bool shadow_casters_only          = false;
+            uint32_t bucket                   = 0;
+            vector<Renderer_DrawCall>* visible = nullptr;
+
+            // batching, only for the plain opaque bucket, 0 if the view doesn't batch
+            uint8_t batch_flags                         = 0;
+            vector<Renderer_DrawCall>* batches          = nullptr;
+            vector<uint32_t>* batched                   = nullptr;
+            vector<Renderer_DrawCall>* visible_instanced = nullptr;
+
+            // instance culling, only for the instanced buckets
+            vector<uint32_t>* instances = nullptr;
+
+            // depth is the squared distance from the eye, or, for directional lights, the distance along the direction
+            Vector3 eye         = Vector3::Zero;
+            Vector3 direction   = Vector3::Zero;
+            bool is_directional = false;
+        };
+
+        // dense, per-frame, indices for materials and geometry (a mesh and an index range), so that they fit in a sort key
+        struct geometry_hash
+        {
+            size_t operator()(const pair<const Mesh*, uint32_t>& geometry) const
+            {
+                return hash<const Mesh*>()(geometry.first) ^ (static_cast<size_t>(geometry.second) * 0x9E3779B97F4A7C15ull);
+            }
+        };
+        unordered_map<const Material*, uint32_t> state_indices_material;
+        unordered_map<pair<const Mesh*, uint32_t>, uint32_t, geometry_hash> state_indices_geometry;
+
+        uint32_t draw_state(const Renderable* renderable, const uint32_t index_offset)
+        {
+            auto index = [](auto& indices, const auto& state)
+            {
+                // past 16 bits, draws still sort correctly, they just share a bin
+                auto it = indices.try_emplace(state, min(static_cast<uint32_t>(indices.size()), 0xFFFFu)).first;
+                return it->second;
+            };
+
+            const uint32_t material = index(state_indices_material, renderable->GetMaterial());
+            const uint32_t geometry = index(state_indices_geometry, make_pair(static_cast<const Mesh*>(renderable->GetMesh()), index_offset));
+
+            return (material << 16) | geometry;
+        }
+
+        bool can_batch_together(const Renderable* a, const Renderable* b)
+        {
+            return a->GetMesh()         == b->GetMesh()         &&
+                   a->GetMaterial()     == b->GetMaterial()     &&
+                   a->GetIndexOffset()  == b->GetIndexOffset()  &&
+                   a->GetIndexCount()   == b->GetIndexCount()   &&
+                   a->GetVertexOffset() == b->GetVertexOffset();
+        }
+
+        Renderer_DrawCall draw_call(Entity* entity, Renderable* renderable, const uint32_t lod)
+        {
+            const MeshLod range = renderable->GetLodIndexRange(lod);
+
+            Renderer_DrawCall draw;
+            draw.entity       = entity;
+            draw.renderable   = renderable;
+            draw.index_offset = range.index_offset;
+            draw.index_count  = range.index_count;
+            if (renderable->HasInstancing())
+            {
+                draw.instance_buffer = renderable->GetInstanceBuffer();
+                draw.instance_count  = renderable->GetInstanceCount();
+            }
+
+            return draw;
+        }
+    }
+
+    void Renderer::Visibility_OnFrameStart()
+    {
+        SP_PROFILE_FUNCTION();
+
+        frame++;
+
+        // gather bounding boxes, and the buckets, so that the workers don't have to look them up in m_renderables
+        state_indices_material.clear();
+        state_indices_geometry.clear();
+        array<const vector<shared_ptr<Entity>>*, bucket_count> buckets;
+
+        // lods are picked once, from the camera, so that every view draws the same geometry
+        Camera* camera                = m_camera.get();
+        const Vector3 camera_position = camera ? camera->GetTransform()->GetPosition() : Vector3::Zero;
+        const float camera_fov        = camera ? camera->GetFovVerticalRad() : 0.0f;
+        for (uint32_t bucket = 0; bucket < bucket_count; bucket++)
+        {
+            const vector<shared_ptr<Entity>>& entities = m_renderables[static_cast<Renderer_Entity>(bucket)];
+            bucket_boxes& aabbs                        = boxes[bucket];
+            buckets[bucket]                            = &entities;
+
+            aabbs.resize(entities.size());
+            for (uint32_t i = 0; i < static_cast<uint32_t>(entities.size()); i++)
+            {
+                Entity* entity         = entities[i].get();
+                Renderable* renderable = entity->GetComponent<Renderable>().get();
+                aabbs.renderables[i]   = renderable;
+                if (camera)
+                {
+                    renderable->UpdateLods(camera_position, camera_fov);
+                }
+
+                aabbs.bounds.set(i, renderable->GetBoundingBox());
+                aabbs.casts_shadows[i] = renderable->GetCastShadows() ? 1 : 0;
+                aabbs.lod[i]           = static_cast<uint8_t>(renderable->GetLod());
+                aabbs.state[i]         = draw_state(renderable, renderable->GetLodIndexRange(aabbs.lod[i]).index_offset);
+                aabbs.instance_offsets[i + 1] = aabbs.instance_offsets[i] + (renderable->HasInstancing() ? renderable->GetInstanceCount() : 0);
+
+                aabbs.batchable[i] = 0;
+                if (bucket == static_cast<uint32_t>(Renderer_Entity::Geometry) && renderable->GetMesh())
+                {
+                    const Material* material = renderable->GetMaterial();
+                    if (!material || material->GetProperty(MaterialProperty::VertexAnimateWind) == 0.0f)
+                    {
+                        aabbs.batchable[i] |= batch_flag_shadow;
+                        aabbs.batchable[i] |= entity->GetTransform()->GetMatrix() == entity->GetTransform()->GetMatrixPrevious() ? batch_flag_static : 0;
+                    }
+                }
+            }
+
+            // the bounding boxes of each instance, so that views can cull instances too
+            aabbs.instance_bounds.resize(aabbs.instance_offsets.back());
+            for (uint32_t i = 0; i < static_cast<uint32_t>(entities.size()); i++)
+            {
+                if (aabbs.instance_offsets[i + 1] == aabbs.instance_offsets[i])
+                    continue;
+
+                const vector<BoundingBox>& instance_boxes = aabbs.renderables[i]->GetBoundingBoxInstances();
+                for (uint32_t instance_index = 0; instance_index < static_cast<uint32_t>(instance_boxes.size()); instance_index++)
+                {
+                    aabbs.instance_bounds.set(aabbs.instance_offsets[i] + instance_index, instance_boxes[instance_index]);
+                }
+            }
+        }
+
+        // gather views, one task per view and bucket
+        vector<view_task> tasks;
+        auto add_view = [&tasks](const Component* view, const Frustum& frustum, const uint32_t view_index, const uint32_t bucket_end, const bool is_light, const bool is_directional, const uint8_t batch_flags)
+        {
+            view_visibility& visibility = views[view];
+            visibility.frame            = frame;
+            const Vector3 eye           = view->GetTransform()->GetPosition();
+            const Vector3 direction     = view->GetTransform()->GetForward();
+
+            for (uint32_t bucket = 0; bucket < bucket_end; bucket++)
+            {
+                view_task task;
+                task.frustum             = &frustum;
+                task.ignore_near_plane   = is_directional;
+                task.shadow_casters_only = is_light;
+                task.bucket              = bucket;
+                task.visible             = &visibility.visible[view_index][bucket];
+                task.eye                 = eye;
+                task.direction           = direction;
+                task.is_directional      = is_directional;
+                task.instances           = (bucket == static_cast<uint32_t>(Renderer_Entity::GeometryInstanced) || bucket == static_cast<uint32_t>(Renderer_Entity::GeometryTransparentInstanced)) ? &visibility.instances[view_index][bucket] : nullptr;
+
+                // the batches go to the instanced bucket, so the view has to have one
+                if (batch_flags != 0 && bucket == static_cast<uint32_t>(Renderer_Entity::Geometry) && bucket_end > static_cast<uint32_t>(Renderer_Entity::GeometryInstanced))
+                {
+                    task.batch_flags       = batch_flags;
+                    task.batches           = &visibility.batches[view_index];
+                    task.batched           = &visibility.batched[view_index];
+                    task.visible_instanced = &visibility.visible[view_index][static_cast<uint32_t>(Renderer_Entity::GeometryInstanced)];
+                }
+
+                tasks.emplace_back(task);
+            }
+        };
+
+        if (camera)
+        {
+            // the g-buffer needs the previous transform of each instance for velocity, so only static renderables are batched
+            add_view(camera, camera->GetFrustum(), 0, bucket_count, false, false, batch_flag_shadow | batch_flag_static);
+        }
+
+        for (const shared_ptr<Entity>& entity : m_renderables[Renderer_Entity::Light])
+        {
+            Light* light = entity->GetComponent<Light>().get();
+            if (!light || !light->GetShadowsEnabled() || !light->GetDepthTexture())
+                continue;
+
+            // transparent geometry only needs culling if the light has transparent shadows
+            const uint32_t bucket_end  = light->GetShadowsTransparentEnabled() ? bucket_count : 2;
+            const uint32_t array_count = min(light->GetDepthTexture()->GetArrayLength(), view_index_count);
+            const bool is_directional  = light->GetLightType() == LightType::Directional;
+            for (uint32_t array_index = 0; array_index < array_count; array_index++)
+            {
+                add_view(light, light->GetFrustum(array_index), array_index, bucket_end, true, is_directional, batch_flag_shadow);
+            }
+        }
+
+        for (const shared_ptr<Entity>& entity : m_renderables[Renderer_Entity::ReflectionProbe])
+        {
+            ReflectionProbe* probe = entity->GetComponent<ReflectionProbe>().get();
+            if (!probe || !probe->GetNeedsToUpdate())
+                continue;
+
+            // probes only render opaque, non-instanced, geometry
+            for (uint32_t face_index = 0; face_index < view_index_count; face_index++)
+            {
+                add_view(probe, probe->GetFrustum(face_index), face_index, 1, false, false, 0);
+            }
+        }
+
+        // drop views which are gone, their lists would never be asked for again
+        for (auto it = views.begin(); it != views.end();)
+        {
+            it = it->second.frame != frame ? views.erase(it) : next(it);
+        }
+
+        // cull, each task writes to its own list, so they can all run at once
+        ThreadPool::ParallelLoop([&tasks, &buckets](uint32_t start, uint32_t end)
+        {
+            for (uint32_t task_index = start; task_index < end; task_index++)
+            {
+                const view_task& task                      = tasks[task_index];
+                const bucket_boxes& aabbs                  = boxes[task.bucket];
+                const vector<shared_ptr<Entity>>& entities = *buckets[task.bucket];
+
+                // test the whole bucket, then compact the visible bits into draw packets
+                thread_local vector<uint64_t> visibility;
+                visibility.resize((entities.size() + 63) / 64);
+                task.frustum->IsVisible(aabbs.get(), visibility.data(), task.ignore_near_plane);
+
+                thread_local vector<draw_packet> packets;
+                thread_local vector<draw_packet> packets_scratch;
+                packets.clear();
+                for (uint32_t word_index = 0; word_index < static_cast<uint32_t>(visibility.size()); word_index++)
+                {
+                    for (uint64_t word = visibility[word_index]; word != 0; word &= word - 1)
+                    {
+                        const uint32_t i = word_index * 64 + static_cast<uint32_t>(countr_zero(word));
+                        if (task.shadow_casters_only && !aabbs.casts_shadows[i])
+                            continue;
+
+                        const Vector3 to_center = Vector3(aabbs.bounds.center_x[i], aabbs.bounds.center_y[i], aabbs.bounds.center_z[i]) - task.eye;
+                        const float depth       = task.is_directional ? to_center.Dot(task.direction) : to_center.LengthSquared();
+                        packets.push_back({ key_make(task.bucket, aabbs.state[i], depth), i });
+                    }
+                }
+
+                // sort them, this is what gets rid of redundant state changes in the passes
+                radix_sort(packets, packets_scratch);
+
+                task.visible->clear();
+                if (task.instances)
+                {
+                    // cull the instances of each visible renderable, and keep the indices of the visible ones
+                    task.instances->clear();
+                    for (const draw_packet& packet : packets)
+                    {
+                        const FrustumBoxes instance_boxes = aabbs.get_instances(packet.index);
+                        visibility.resize((instance_boxes.count + 63) / 64);
+                        task.frustum->IsVisible(instance_boxes, visibility.data(), task.ignore_near_plane);
+
+                        thread_local vector<uint32_t> instances_visible;
+                        instances_visible.clear();
+                        for (uint32_t word_index = 0; word_index < static_cast<uint32_t>(visibility.size()); word_index++)
+                        {
+                            for (uint64_t word = visibility[word_index]; word != 0; word &= word - 1)
+                            {
+                                instances_visible.emplace_back(word_index * 64 + static_cast<uint32_t>(countr_zero(word)));
+                            }
+                        }
+
+                        // one draw per lod, with the instances of each one next to each other
+                        Entity* entity              = entities[packet.index].get();
+                        Renderable* renderable      = aabbs.renderables[packet.index];
+                        const vector<uint8_t>& lods = renderable->GetLodsInstances();
+                        const bool has_lods          = renderable->GetMesh() && renderable->GetMesh()->HasLods() && lods.size() == instance_boxes.count;
+                        for (uint32_t lod = 0; lod < (has_lods ? mesh_lod_count : 1); lod++)
+                        {
+                            Renderer_DrawCall draw = draw_call(entity, renderable, lod);
+                            draw.instance_start    = static_cast<uint32_t>(task.instances->size());
+                            for (const uint32_t instance_index : instances_visible)
+                            {
+                                if (!has_lods || lods[instance_index] == lod)
+                                {
+                                    task.instances->emplace_back(instance_index);
+                                }
+                            }
+
+                            draw.instance_count = static_cast<uint32_t>(task.instances->size()) - draw.instance_start;
+                            if (draw.instance_count != 0)
+                            {
+                                task.visible->emplace_back(draw);
+                            }
+                        }
+                    }
+
+                    continue;
+                }
+
+                if (task.batch_flags == 0)
+                {
+                    for (const draw_packet& packet : packets)
+                    {
+                        Entity* entity = entities[packet.index].get();
+                        task.visible->emplace_back(draw_call(entity, aabbs.renderables[packet.index], aabbs.lod[packet.index]));
+                    }
+
+                    continue;
+                }
+
+                // batch, draws with the same geometry and material are next to each other after sorting
+                task.batches->clear();
+                task.batched->clear();
+                for (uint32_t packet_index = 0; packet_index < static_cast<uint32_t>(packets.size());)
+                {
+                    const uint32_t first   = packets[packet_index].index;
+                    Entity* entity         = entities[first].get();
+                    Renderable* renderable = aabbs.renderables[first];
+
+                    uint32_t run_end = packet_index + 1;
+                    if ((aabbs.batchable[first] & task.batch_flags) == task.batch_flags)
+                    {
+                        while (run_end < packets.size())
+                        {
+                            const uint32_t next = packets[run_end].index;
+                            if (aabbs.state[next] != aabbs.state[first] || aabbs.lod[next] != aabbs.lod[first] || (aabbs.batchable[next] & task.batch_flags) != task.batch_flags)
+                                break;
+
+                            if (!can_batch_together(renderable, aabbs.renderables[next]))
+                                break;
+
+                            run_end++;
+                        }
+                    }
+
+                    const uint32_t run_size = run_end - packet_index;
+                    if (run_size >= batch_size_min)
+                    {
+                        Renderer_DrawCall batch = draw_call(entity, renderable, aabbs.lod[first]);
+                        batch.instance_start = static_cast<uint32_t>(task.batched->size());
+                        batch.instance_count = run_size;
+                        batch.is_batch       = true;
+                        task.batches->emplace_back(batch);
+
+                        for (uint32_t run_index = packet_index; run_index < run_end; run_index++)
+                        {
+                            task.batched->emplace_back(packets[run_index].index);
+                        }
+                    }
+                    else
+                    {
+                        task.visible->emplace_back(draw_call(entity, renderable, aabbs.lod[first]));
+                    }
+
+                    packet_index = run_end;
+                }
+            }
+        }, static_cast<uint32_t>(tasks.size()), 1);
+
+        // upload the transforms of the visible instances and of the batched renderables, batches move to the instanced buckets
+        uint32_t instance_count = 0;
+        for (const view_task& task : tasks)
+        {
+            instance_count += task.instances ? static_cast<uint32_t>(task.instances->size()) : 0;
+            instance_count += task.batched   ? static_cast<uint32_t>(task.batched->size())   : 0;
+        }
+
+        if (instance_count == 0)
+            return;
+
+        // one buffer per frame that the gpu can be behind
+        shared_ptr<RHI_VertexBuffer>& instance_buffer = m_vertex_buffers_instances[frame % m_vertex_buffers_instances.size()];
+        if (!instance_buffer)
+        {
+            instance_buffer = make_shared<RHI_VertexBuffer>(true, "instance_buffer_visible");
+        }
+
+        if (instance_count > instance_buffer->GetVertexCount())
+        {
+            instance_buffer->CreateDynamic<Matrix>(instance_count);
+        }
+
+        // if the buffer can't be written to, instances are drawn from their renderables and batches one by one
+        Matrix* instances        = static_cast<Matrix*>(instance_buffer->GetMappedData());
+        uint32_t instance_offset = 0;
+        for (const view_task& task : tasks)
+        {
+            if (task.instances)
+            {
+                if (!instances)
+                {
+                    // the draws of each lod become one draw of all the instances
+                    vector<Renderer_DrawCall>& visible = *task.visible;
+                    visible.erase(unique(visible.begin(), visible.end(), [](const Renderer_DrawCall& a, const Renderer_DrawCall& b)
+                    {
+                        return !a.is_batch && !b.is_batch && a.entity == b.entity;
+                    }), visible.end());
+                }
+
+                for (Renderer_DrawCall& draw : *task.visible)
+                {
+                    if (draw.is_batch)
+                        continue;
+
+                    Renderable* renderable = draw.renderable;
+                    if (!instances)
+                    {
+                        draw = draw_call(draw.entity, renderable, 0);
+                        continue;
+                    }
+
+                    // already transposed
+                    const vector<Matrix>& transforms = renderable->GetInstances();
+                    for (uint32_t i = 0; i < draw.instance_count; i++)
+                    {
+                        instances[instance_offset + i] = transforms[(*task.instances)[draw.instance_start + i]];
+                    }
+
+                    draw.instance_buffer = instance_buffer.get();
+                    draw.instance_start  = instance_offset;
+                    instance_offset     += draw.instance_count;
+                }
+            }
+
+            if (task.batches)
+            {
+                for (Renderer_DrawCall& batch : *task.batches)
+                {
+                    if (!instances)
+                    {
+                        for (uint32_t i = 0; i < batch.instance_count; i++)
+                        {
+                            const uint32_t index   = (*task.batched)[batch.instance_start + i];
+                            Renderable* renderable = boxes[task.bucket].renderables[index];
+                            task.visible->emplace_back(draw_call((*buckets[task.bucket])[index].get(), renderable, renderable->GetLod()));
+                        }
+
+                        continue;
+                    }
+
+                    // transposed, like all instance transforms (see Terrain.cpp)
+                    for (uint32_t i = 0; i < batch.instance_count; i++)
+                    {
+                        instances[instance_offset + i] = (*buckets[task.bucket])[(*task.batched)[batch.instance_start + i]]->GetTransform()->GetMatrix().Transposed();
+                    }
+
+                    batch.instance_buffer = instance_buffer.get();
+                    batch.instance_start  = instance_offset;
+                    instance_offset      += batch.instance_count;
+                    task.visible_instanced->emplace_back(batch);
+                }
+            }
+        }
+    }
+
+    const vector<Renderer_DrawCall>& Renderer::Visibility_Get(const Component* view, const uint32_t view_index, const Renderer_Entity type)
+    {
+        static const vector<Renderer_DrawCall> empty;
+
+        const uint32_t bucket = static_cast<uint32_t>(type);
+        if (!view || view_index >= view_index_count || bucket >= bucket_count)
+            return empty;
+
+        auto it = views.find(view);
+        if (it == views.end() || it->second.frame != frame)
+            return empty;
+
+        return it->second.visible[view_index][bucket];
+    }
+}
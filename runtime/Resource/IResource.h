@@ -111,6 +111,10 @@ namespace Spartan
         // ready to use
         bool IsReadyForUse() const { return m_is_ready_for_use; }
 
+        // size of the native file, as stored and uncompressed
+        uint64_t GetFileSize()             const { return m_file_size; }
+        uint64_t GetFileSizeUncompressed() const { return m_file_size_uncompressed; }
+
         // io
         virtual bool SaveToFile(const std::string& file_path) { return true; }
         virtual bool LoadFromFile(const std::string& file_path) { return true; }
@@ -123,6 +127,8 @@ namespace Spartan
         ResourceType m_resource_type         = ResourceType::Unknown;
         std::atomic<bool> m_is_ready_for_use = false;
         uint32_t m_flags                     = 0;
+        uint64_t m_file_size                 = 0;
+        uint64_t m_file_size_uncompressed    = 0;
 
     private:
         std::string m_resource_directory;
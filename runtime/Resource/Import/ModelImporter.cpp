@@ -23,6 +23,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "pch.h"
 #include "ModelImporter.h"
 #include "../../Core/ProgressTracker.h"
+#include "../../Core/ThreadPool.h"
 #include "../../RHI/RHI_Texture.h"
 #include "../../Rendering/Animation.h"
 #include "../../Rendering/Mesh.h"
@@ -55,6 +56,18 @@ namespace Spartan
         bool model_has_animation = false;
         bool model_is_gltf       = false;
         const aiScene* scene     = nullptr;
+
+        // geometry parsed by the child jobs of the parse job, it's given to the renderables once they have all finished
+        struct mesh_geometry
+        {
+            Renderable* renderable = nullptr;
+            BoundingBox aabb;
+            uint32_t index_offset  = 0;
+            uint32_t index_count   = 0;
+            uint32_t vertex_offset = 0;
+            uint32_t vertex_count  = 0;
+        };
+        deque<mesh_geometry> mesh_geometries; // a deque, so that the child jobs can hold on to their element
     }
 
     static Matrix convert_matrix(const aiMatrix4x4& transform)
@@ -321,6 +334,78 @@ namespace Spartan
         return material;
     }
 
+    static void parse_mesh_geometry(const aiMesh* assimp_mesh, mesh_geometry* geometry)
+    {
+        const uint32_t vertex_count = assimp_mesh->mNumVertices;
+        const uint32_t index_count  = assimp_mesh->mNumFaces * 3;
+
+        // vertices
+        vector<RHI_Vertex_PosTexNorTan> vertices = vector<RHI_Vertex_PosTexNorTan>(vertex_count);
+        {
+            for (uint32_t i = 0; i < vertex_count; i++)
+            {
+                RHI_Vertex_PosTexNorTan& vertex = vertices[i];
+
+                // position
+                const aiVector3D& pos = assimp_mesh->mVertices[i];
+                vertex.pos[0] = pos.x;
+                vertex.pos[1] = pos.y;
+                vertex.pos[2] = pos.z;
+
+                // normal
+                if (assimp_mesh->mNormals)
+                {
+                    const aiVector3D& normal = assimp_mesh->mNormals[i];
+                    vertex.nor[0] = normal.x;
+                    vertex.nor[1] = normal.y;
+                    vertex.nor[2] = normal.z;
+                }
+
+                // tangent
+                if (assimp_mesh->mTangents)
+                {
+                    const aiVector3D& tangent = assimp_mesh->mTangents[i];
+                    vertex.tan[0] = tangent.x;
+                    vertex.tan[1] = tangent.y;
+                    vertex.tan[2] = tangent.z;
+                }
+
+                // texture coordinates
+                const uint32_t uv_channel = 0;
+                if (assimp_mesh->HasTextureCoords(uv_channel))
+                {
+                    const auto& tex_coords = assimp_mesh->mTextureCoords[uv_channel][i];
+                    vertex.tex[0] = tex_coords.x;
+                    vertex.tex[1] = tex_coords.y;
+                }
+            }
+        }
+
+        // indices
+        vector<uint32_t> indices = vector<uint32_t>(index_count);
+        {
+            // get indices by iterating through each face of the mesh.
+            for (uint32_t face_index = 0; face_index < assimp_mesh->mNumFaces; face_index++)
+            {
+                // if (aiPrimitiveType_LINE | aiPrimitiveType_POINT) && aiProcess_Triangulate) then (face.mNumIndices == 3)
+                const aiFace& face           = assimp_mesh->mFaces[face_index];
+                const uint32_t indices_index = (face_index * 3);
+                indices[indices_index + 0]   = face.mIndices[0];
+                indices[indices_index + 1]   = face.mIndices[1];
+                indices[indices_index + 2]   = face.mIndices[2];
+            }
+        }
+
+        // compute AABB (before doing move operation on vertices)
+        const BoundingBox aabb = BoundingBox(vertices.data(), static_cast<uint32_t>(vertices.size()));
+
+        // add vertex and index data to the mesh
+        mesh->AddGeometry(vertices, indices, &geometry->vertex_offset, &geometry->index_offset);
+        geometry->index_count  = index_count;
+        geometry->vertex_count = vertex_count;
+        geometry->aabb         = aabb;
+    }
+
     void ModelImporter::Initialize()
     {
         // Get version
@@ -416,15 +501,26 @@ namespace Spartan
 
             model_has_animation = scene->mNumAnimations != 0;
 
-            // recursively parse nodes
-            ParseNode(scene->mRootNode);
+            // recursively parse nodes, entities and components are created serially while the geometry is parsed by child jobs
+            JobHandle job_parse;
+            job_parse = ThreadPool::CreateJob([&job_parse]()
+            {
+                ParseNode(scene->mRootNode, job_parse);
+            });
 
-            // update model geometry
+            // update model geometry, once the nodes and all the meshes have been parsed
+            JobHandle job_geometry = ThreadPool::CreateJob([]()
             {
-                while (ProgressTracker::GetProgress(ProgressType::ModelImporter).GetFraction() != 1.0f)
+                for (const mesh_geometry& geometry : mesh_geometries)
                 {
-                    SP_LOG_INFO("Waiting for node processing threads to finish before creating GPU buffers...");
-                    this_thread::sleep_for(std::chrono::milliseconds(16));
+                    geometry.renderable->SetGeometry(
+                        mesh,
+                        geometry.aabb,
+                        geometry.index_offset,
+                        geometry.index_count,
+                        geometry.vertex_offset,
+                        geometry.vertex_count
+                    );
                 }
 
                 // optimize
@@ -445,8 +541,22 @@ namespace Spartan
                     mesh->GetRootEntity()->GetTransform()->SetScale(normalized_scale);
                 }
 
+                // lods, after any optimization since they are built from the final indices
+                if (mesh->GetFlags() & static_cast<uint32_t>(MeshFlags::GenerateLods))
+                {
+                    mesh->GenerateLods();
+                }
+
                 mesh->CreateGpuBuffers();
-            }
+            });
+
+            ThreadPool::AddContinuation(job_parse, job_geometry);
+            ThreadPool::Run(job_geometry);
+            ThreadPool::Run(job_parse);
+
+            // the import is synchronous, so help with the jobs until it's done
+            ThreadPool::Wait(job_geometry);
+            mesh_geometries.clear();
 
             // make the root entity active since it's now thread-safe
             mesh->GetRootEntity()->SetActive(true);
@@ -464,7 +574,7 @@ namespace Spartan
         return scene != nullptr;
     }
 
-    void ModelImporter::ParseNode(const aiNode* node, shared_ptr<Entity> parent_entity)
+    void ModelImporter::ParseNode(const aiNode* node, const JobHandle& job_parse, shared_ptr<Entity> parent_entity)
     {
         // Create an entity that will match this node.
         shared_ptr<Entity> entity = World::CreateEntity();
@@ -496,7 +606,7 @@ namespace Spartan
         // Mesh components
         if (node->mNumMeshes > 0)
         {
-            ParseNodeMeshes(node, entity.get());
+            ParseNodeMeshes(node, entity.get(), job_parse);
         }
 
         // Light component
@@ -508,14 +618,14 @@ namespace Spartan
         // Children nodes
         for (uint32_t i = 0; i < node->mNumChildren; i++)
         {
-            ParseNode(node->mChildren[i], entity);
+            ParseNode(node->mChildren[i], job_parse, entity);
         }
 
         // Update progress tracking
         ProgressTracker::GetProgress(ProgressType::ModelImporter).JobDone();
     }
 
-    void ModelImporter::ParseNodeMeshes(const aiNode* assimp_node, Entity* node_entity)
+    void ModelImporter::ParseNodeMeshes(const aiNode* assimp_node, Entity* node_entity, const JobHandle& job_parse)
     {
         // An aiNode can have any number of meshes (albeit typically, it's one).
         // If it has more than one meshes, then we create children entities to store them.
@@ -545,7 +655,7 @@ namespace Spartan
             entity->SetObjectName(node_name);
             
             // Load the mesh onto the entity (via a Renderable component)
-            ParseMesh(node_mesh, entity);
+            ParseMesh(node_mesh, entity, job_parse);
         }
     }
 
@@ -592,93 +702,14 @@ namespace Spartan
         }
     }
 
-    void ModelImporter::ParseMesh(aiMesh* assimp_mesh, Entity* entity_parent)
+    void ModelImporter::ParseMesh(aiMesh* assimp_mesh, Entity* entity_parent, const JobHandle& job_parse)
     {
         SP_ASSERT(assimp_mesh != nullptr);
         SP_ASSERT(entity_parent != nullptr);
 
-        const uint32_t vertex_count = assimp_mesh->mNumVertices;
-        const uint32_t index_count  = assimp_mesh->mNumFaces * 3;
-
-        // vertices
-        vector<RHI_Vertex_PosTexNorTan> vertices = vector<RHI_Vertex_PosTexNorTan>(vertex_count);
-        {
-            for (uint32_t i = 0; i < vertex_count; i++)
-            {
-                RHI_Vertex_PosTexNorTan& vertex = vertices[i];
-
-                // position
-                const aiVector3D& pos = assimp_mesh->mVertices[i];
-                vertex.pos[0] = pos.x;
-                vertex.pos[1] = pos.y;
-                vertex.pos[2] = pos.z;
-
-                // normal
-                if (assimp_mesh->mNormals)
-                {
-                    const aiVector3D& normal = assimp_mesh->mNormals[i];
-                    vertex.nor[0] = normal.x;
-                    vertex.nor[1] = normal.y;
-                    vertex.nor[2] = normal.z;
-                }
-
-                // tangent
-                if (assimp_mesh->mTangents)
-                {
-                    const aiVector3D& tangent = assimp_mesh->mTangents[i];
-                    vertex.tan[0] = tangent.x;
-                    vertex.tan[1] = tangent.y;
-                    vertex.tan[2] = tangent.z;
-                }
-
-                // texture coordinates
-                const uint32_t uv_channel = 0;
-                if (assimp_mesh->HasTextureCoords(uv_channel))
-                {
-                    const auto& tex_coords = assimp_mesh->mTextureCoords[uv_channel][i];
-                    vertex.tex[0] = tex_coords.x;
-                    vertex.tex[1] = tex_coords.y;
-                }
-            }
-        }
-
-        // indices
-        vector<uint32_t> indices = vector<uint32_t>(index_count);
-        {
-            // get indices by iterating through each face of the mesh.
-            for (uint32_t face_index = 0; face_index < assimp_mesh->mNumFaces; face_index++)
-            {
-                // if (aiPrimitiveType_LINE | aiPrimitiveType_POINT) && aiProcess_Triangulate) then (face.mNumIndices == 3)
-                const aiFace& face           = assimp_mesh->mFaces[face_index];
-                const uint32_t indices_index = (face_index * 3);
-                indices[indices_index + 0]   = face.mIndices[0];
-                indices[indices_index + 1]   = face.mIndices[1];
-                indices[indices_index + 2]   = face.mIndices[2];
-            }
-        }
-
-        // compute AABB (before doing move operation on vertices)
-        const BoundingBox aabb = BoundingBox(vertices.data(), static_cast<uint32_t>(vertices.size()));
-
-        // add vertex and index data to the mesh
-        uint32_t index_offset  = 0;
-        uint32_t vertex_offset = 0;
-        mesh->AddIndices(indices,  &index_offset);
-        mesh->AddVertices(vertices, &vertex_offset);
-
-        // add a renderable component to this entity
+        // add a renderable component to this entity, its geometry is set once all the meshes have been parsed
         shared_ptr<Renderable> renderable = entity_parent->AddComponent<Renderable>();
 
-        // set the geometry
-        renderable->SetGeometry(
-            mesh,
-            aabb,
-            index_offset,
-            static_cast<uint32_t>(indices.size()),
-            vertex_offset,
-            static_cast<uint32_t>(vertices.size())
-        );
-
         // material
         if (scene->HasMaterials())
         {
@@ -693,6 +724,14 @@ namespace Spartan
 
         // Bones
         ParseNodes(assimp_mesh);
+
+        // the geometry is the expensive part and it doesn't touch the entity, so it's parsed by a child job
+        mesh_geometry* geometry = &mesh_geometries.emplace_back();
+        geometry->renderable    = renderable.get();
+        ThreadPool::Run(ThreadPool::CreateJob([assimp_mesh, geometry]()
+        {
+            parse_mesh_geometry(assimp_mesh, geometry);
+        }, job_parse));
     }
 
     void ModelImporter::ParseAnimations()
@@ -24,6 +24,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 //= INCLUDES ======================
 #include <string>
 #include "../../Core/Definitions.h"
+#include "../../Core/ThreadPool.h"
 //=================================
 
 struct aiNode;
@@ -41,11 +42,11 @@ namespace Spartan
         static bool Load(Mesh* mesh, const std::string& file_path);
 
     private:
-        static void ParseNode(const aiNode* node, std::shared_ptr<Entity> parent_entity = nullptr);
-        static void ParseNodeMeshes(const aiNode* node, Entity* new_entity);
+        static void ParseNode(const aiNode* node, const JobHandle& job_parse, std::shared_ptr<Entity> parent_entity = nullptr);
+        static void ParseNodeMeshes(const aiNode* node, Entity* new_entity, const JobHandle& job_parse);
         static void ParseNodeLight(const aiNode* node, Entity* new_entity);
         static void ParseAnimations();
-        static void ParseMesh(aiMesh* mesh, Entity* entity_parent);
+        static void ParseMesh(aiMesh* mesh, Entity* entity_parent, const JobHandle& job_parse);
         static void ParseNodes(const aiMesh* mesh);
     };
 }
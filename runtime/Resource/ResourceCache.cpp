@@ -24,11 +24,14 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "ResourceCache.h"
 #include "../World/World.h"
 #include "../IO/FileStream.h"
+#include "../IO/AssetFile.h"
 #include "../RHI/RHI_Texture2D.h"
 #include "../RHI/RHI_Texture2DArray.h"
 #include "../RHI/RHI_TextureCube.h"
 #include "../Audio/AudioClip.h"
 #include "../Rendering/Mesh.h"
+#include "../Core/ThreadPool.h"
+#include <future>
 //====================================
 
 //= NAMESPACES ================
@@ -40,11 +43,173 @@ namespace Spartan
 {
     namespace
     {
+        // resources which share a name or a path (but not a type) land in the same bucket, buckets hold ids
+        // so that m_resources is the only strong reference the cache has, which is what eviction relies on
+        using resource_bucket = vector<uint64_t>;
+
+        struct resource_entry
+        {
+            string path; // keys at the time of caching, so that removal doesn't depend on the resource
+            string name;
+            uint32_t index = 0; // position in m_resources
+        };
+
+        // what's needed to bring an evicted resource back
+        struct evicted_entry
+        {
+            ResourceType type = ResourceType::Unknown;
+            string name;
+        };
+
         array<string, 6> m_standard_resource_directories;
         string m_project_directory;
         vector<shared_ptr<IResource>> m_resources;
-        mutex m_mutex;
+        vector<uint64_t> m_last_used_frame; // parallel to m_resources, Tick() writes it under the shared lock through atomic_ref
+        unordered_map<uint64_t, resource_entry> m_index_id;
+        unordered_map<string, resource_bucket> m_index_path;
+        unordered_map<string, resource_bucket> m_index_name;
+        shared_mutex m_mutex;
         bool use_root_shader_directory = false;
+
+        // loads which are in progress, keyed by type and path, so that concurrent requests share them
+        mutex m_mutex_loads;
+        unordered_map<string, shared_future<shared_ptr<IResource>>> m_loads_in_flight;
+
+        // eviction
+        atomic<uint64_t> m_budget_cpu = 0; // bytes, 0 means unlimited
+        atomic<uint64_t> m_budget_gpu = 0; // bytes, 0 means unlimited
+        atomic<uint32_t> m_eviction_frame_threshold = 300;
+        atomic<uint64_t> m_frame = 0; // only advances while there is a budget, so nothing ages while it's unlimited
+        unordered_map<string, evicted_entry> m_evicted;     // keyed by native path
+        unordered_map<string, string> m_evicted_name_to_path;
+
+        // prefers a resource of the requested type, falls back to the first one
+        shared_ptr<IResource> find_in_bucket(const unordered_map<string, resource_bucket>& index, const string& key, const ResourceType type, const bool exact_type)
+        {
+            auto it = index.find(key);
+            if (it == index.end())
+                return nullptr;
+
+            for (const uint64_t id : it->second)
+            {
+                const shared_ptr<IResource>& resource = m_resources[m_index_id.at(id).index];
+                if (resource->GetResourceType() == type)
+                    return resource;
+            }
+
+            return exact_type ? nullptr : m_resources[m_index_id.at(it->second.front()).index];
+        }
+
+        void remove_from_bucket(unordered_map<string, resource_bucket>& index, const string& key, const uint64_t id)
+        {
+            auto it = index.find(key);
+            if (it == index.end())
+                return;
+
+            resource_bucket& bucket = it->second;
+            bucket.erase(remove(bucket.begin(), bucket.end(), id), bucket.end());
+
+            if (bucket.empty())
+            {
+                index.erase(it);
+            }
+        }
+
+        // expects m_mutex to be exclusively locked, returns the resource so that the caller can release it outside of the lock
+        shared_ptr<IResource> remove_entry(unordered_map<uint64_t, resource_entry>::iterator it)
+        {
+            const uint64_t id            = it->first;
+            const resource_entry& entry = it->second;
+            remove_from_bucket(m_index_path, entry.path, id);
+            remove_from_bucket(m_index_name, entry.name, id);
+
+            // swap with the last resource and pop
+            const uint32_t index            = entry.index;
+            shared_ptr<IResource> resource = move(m_resources[index]);
+            if (index != m_resources.size() - 1)
+            {
+                m_resources[index]       = move(m_resources.back());
+                m_last_used_frame[index] = m_last_used_frame.back();
+                m_index_id[m_resources[index]->GetObjectId()].index = index;
+            }
+            m_resources.pop_back();
+            m_last_used_frame.pop_back();
+
+            m_index_id.erase(it);
+
+            return resource;
+        }
+
+        // meshes are referenced through raw pointers (renderables), so the reference count can't tell if they are still in use,
+        // materials are shared by renderables and they hold their textures, so evicting unused materials is what frees the textures
+        bool is_evictable(const ResourceType type)
+        {
+            return type == ResourceType::Material       ||
+                   type == ResourceType::Texture        ||
+                   type == ResourceType::Texture2d      ||
+                   type == ResourceType::Texture2dArray ||
+                   type == ResourceType::TextureCube    ||
+                   type == ResourceType::Audio;
+        }
+
+        uint64_t get_size_cpu(const IResource* resource)
+        {
+            const SpObject* object = dynamic_cast<const SpObject*>(resource);
+            return object ? object->GetObjectSizeCpu() : 0;
+        }
+
+        uint64_t get_size_gpu(const IResource* resource)
+        {
+            const SpObject* object = dynamic_cast<const SpObject*>(resource);
+            return object ? object->GetObjectSizeGpu() : 0;
+        }
+
+        shared_ptr<IResource> load_by_type(const string& file_path, const ResourceType type)
+        {
+            switch (type)
+            {
+            case ResourceType::Mesh:           return ResourceCache::Load<Mesh>(file_path);
+            case ResourceType::Material:       return ResourceCache::Load<Material>(file_path);
+            case ResourceType::Texture:        return ResourceCache::Load<RHI_Texture>(file_path);
+            case ResourceType::Texture2d:      return ResourceCache::Load<RHI_Texture2D>(file_path);
+            case ResourceType::Texture2dArray: return ResourceCache::Load<RHI_Texture2DArray>(file_path);
+            case ResourceType::TextureCube:    return ResourceCache::Load<RHI_TextureCube>(file_path);
+            case ResourceType::Audio:          return ResourceCache::Load<AudioClip>(file_path);
+            default:                           return nullptr;
+            }
+        }
+
+        // reloads an evicted resource from its native file, the key is either a path or a name
+        shared_ptr<IResource> reload_evicted(const string& key, const bool key_is_name)
+        {
+            string path;
+            ResourceType evicted_type = ResourceType::Unknown;
+            {
+                shared_lock<shared_mutex> lock(m_mutex);
+
+                if (key_is_name)
+                {
+                    auto it = m_evicted_name_to_path.find(key);
+                    if (it == m_evicted_name_to_path.end())
+                        return nullptr;
+
+                    path = it->second;
+                }
+                else
+                {
+                    path = key;
+                }
+
+                auto it = m_evicted.find(path);
+                if (it == m_evicted.end())
+                    return nullptr;
+
+                evicted_type = it->second.type;
+            }
+
+            SP_LOG_INFO("Reloading evicted resource \"%s\"...", path.c_str());
+            return load_by_type(path, evicted_type);
+        }
     }
 
     void ResourceCache::Initialize()
@@ -67,54 +232,251 @@ namespace Spartan
         SP_SUBSCRIBE_TO_EVENT(EventType::WorldClear,     SP_EVENT_HANDLER_STATIC(Shutdown));
     }
 
-    bool ResourceCache::IsCached(const string& resource_file_path_native, const ResourceType resource_type)
+    shared_ptr<IResource> ResourceCache::GetCached(const string& resource_file_path_native, const ResourceType resource_type)
     {
         SP_ASSERT(!resource_file_path_native.empty());
 
-        lock_guard<mutex> guard(m_mutex);
+        shared_lock<shared_mutex> lock(m_mutex);
+        return find_in_bucket(m_index_path, resource_file_path_native, resource_type, true);
+    }
+
+    bool ResourceCache::IsCached(const uint64_t resource_id)
+    {
+        shared_lock<shared_mutex> lock(m_mutex);
+        return m_index_id.find(resource_id) != m_index_id.end();
+    }
 
-        for (shared_ptr<IResource>& resource : m_resources)
+    shared_ptr<IResource> ResourceCache::GetByName(const string& name, const ResourceType type)
+    {
         {
-            if (resource->GetResourceType() != resource_type)
-                continue;
+            shared_lock<shared_mutex> lock(m_mutex);
+            if (shared_ptr<IResource> resource = find_in_bucket(m_index_name, name, type, false))
+                return resource;
+        }
 
-            if (resource_file_path_native == resource->GetResourceFilePathNative())
-                return true;
+        return reload_evicted(name, true);
+    }
+
+    shared_ptr<IResource> ResourceCache::GetByPath(const string& path, const ResourceType type)
+    {
+        {
+            shared_lock<shared_mutex> lock(m_mutex);
+            if (shared_ptr<IResource> resource = find_in_bucket(m_index_path, path, type, false))
+                return resource;
         }
 
-        return false;
+        return reload_evicted(path, false);
     }
 
-    bool ResourceCache::IsCached(const uint64_t resource_id)
+    shared_ptr<IResource> ResourceCache::Add(const shared_ptr<IResource>& resource)
     {
-        lock_guard<mutex> guard(m_mutex);
+        const string& path = resource->GetResourceFilePathNative();
 
-        for (shared_ptr<IResource>& resource : m_resources)
+        // Ensure that this resource is not already cached
         {
-            if (resource_id == resource->GetObjectId())
-                return true;
+            shared_lock<shared_mutex> lock(m_mutex);
+            if (shared_ptr<IResource> cached = find_in_bucket(m_index_path, path, resource->GetResourceType(), true))
+                return cached;
         }
 
-        return false;
+        {
+            unique_lock<shared_mutex> lock(m_mutex);
+
+            // Another thread might have cached it while we were waiting for the lock
+            if (shared_ptr<IResource> cached = find_in_bucket(m_index_path, path, resource->GetResourceType(), true))
+                return cached;
+
+            // Cache it
+            const uint64_t id = resource->GetObjectId();
+            resource_entry entry;
+            entry.path  = path;
+            entry.name  = resource->GetObjectName();
+            entry.index = static_cast<uint32_t>(m_resources.size());
+
+            m_resources.emplace_back(resource);
+            m_last_used_frame.emplace_back(m_frame.load(memory_order_relaxed));
+            m_index_path[entry.path].emplace_back(id);
+            m_index_name[entry.name].emplace_back(id);
+            m_index_id[id] = move(entry);
+
+            // If it was evicted, it's back
+            auto it_evicted = m_evicted.find(path);
+            if (it_evicted != m_evicted.end())
+            {
+                m_evicted_name_to_path.erase(it_evicted->second.name);
+                m_evicted.erase(it_evicted);
+            }
+        }
+
+        // In order to guarantee deserialization, we save it now, outside of the lock. Only the thread which
+        // cached it gets here, others get the cached resource above, so the file isn't written concurrently.
+        resource->SaveToFile(path);
+
+        return resource;
     }
-    
-	shared_ptr<IResource>& ResourceCache::GetByName(const string& name, const ResourceType type)
+
+    shared_ptr<IResource> ResourceCache::LoadDeduplicated(const string& file_path_native, const ResourceType type, const function<shared_ptr<IResource>()>& load)
     {
-        lock_guard<mutex> guard(m_mutex);
+        // keyed like the cache (by native path), so that a foreign file and its native counterpart share a load,
+        // with the separators unified, so that different spellings of the same path do too
+        string key = to_string(static_cast<uint32_t>(type)) + "|" + file_path_native;
+        replace(key.begin(), key.end(), '\\', '/');
 
-        for (shared_ptr<IResource>& resource : m_resources)
+        promise<shared_ptr<IResource>> load_promise;
         {
-            if (name == resource->GetObjectName())
-                return resource;
+            unique_lock<mutex> lock(m_mutex_loads);
+
+            auto it = m_loads_in_flight.find(key);
+            if (it != m_loads_in_flight.end())
+            {
+                shared_future<shared_ptr<IResource>> load_future = it->second;
+                lock.unlock();
+
+                return load_future.get();
+            }
+
+            m_loads_in_flight[key] = load_promise.get_future().share();
         }
 
-        static shared_ptr<IResource> empty;
-        return empty;
+        shared_ptr<IResource> resource = load();
+        load_promise.set_value(resource);
+
+        lock_guard<mutex> lock(m_mutex_loads);
+        m_loads_in_flight.erase(key);
+
+        return resource;
+    }
+
+    void ResourceCache::RemoveById(const uint64_t resource_id)
+    {
+        shared_ptr<IResource> resource;
+        {
+            unique_lock<shared_mutex> lock(m_mutex);
+
+            auto it = m_index_id.find(resource_id);
+            if (it == m_index_id.end())
+                return;
+
+            resource = remove_entry(it);
+        }
+
+        // the resource is released here, outside of the lock
+    }
+
+    void ResourceCache::Tick()
+    {
+        const uint64_t budget_cpu = m_budget_cpu.load(memory_order_relaxed);
+        const uint64_t budget_gpu = m_budget_gpu.load(memory_order_relaxed);
+        const uint64_t threshold  = m_eviction_frame_threshold.load(memory_order_relaxed);
+
+        // unlimited, nothing to track or evict
+        if (budget_cpu == 0 && budget_gpu == 0)
+            return;
+
+        uint64_t usage_cpu = 0;
+        uint64_t usage_gpu = 0;
+
+        // mark anything which is referenced outside of the cache as used during this frame, this only writes the
+        // entries' frames (which nothing else reads under the shared lock), so it doesn't have to block loads
+        {
+            shared_lock<shared_mutex> lock(m_mutex);
+
+            const uint64_t frame = m_frame.fetch_add(1, memory_order_relaxed) + 1;
+            for (uint32_t i = 0; i < static_cast<uint32_t>(m_resources.size()); i++)
+            {
+                const shared_ptr<IResource>& resource = m_resources[i];
+
+                if (resource.use_count() > 1)
+                {
+                    atomic_ref<uint64_t>(m_last_used_frame[i]).store(frame, memory_order_relaxed);
+                }
+
+                usage_cpu += get_size_cpu(resource.get());
+                usage_gpu += get_size_gpu(resource.get());
+            }
+        }
+
+        const auto is_over_budget = [&]()
+        {
+            return (budget_cpu != 0 && usage_cpu > budget_cpu) || (budget_gpu != 0 && usage_gpu > budget_gpu);
+        };
+
+        if (!is_over_budget())
+            return;
+
+        // evict least recently used resources until we are within budget, released outside of the lock
+        vector<shared_ptr<IResource>> evicted;
+        {
+            unique_lock<shared_mutex> lock(m_mutex);
+
+            // only the cache holds a reference to them, and it's been a while since anything did
+            vector<uint32_t> candidates;
+            for (uint32_t i = 0; i < static_cast<uint32_t>(m_resources.size()); i++)
+            {
+                const shared_ptr<IResource>& resource = m_resources[i];
+                if (is_evictable(resource->GetResourceType()) && resource.use_count() == 1 && m_frame.load(memory_order_relaxed) - m_last_used_frame[i] >= threshold)
+                {
+                    candidates.emplace_back(i);
+                }
+            }
+
+            sort(candidates.begin(), candidates.end(), [](const uint32_t a, const uint32_t b) { return m_last_used_frame[a] < m_last_used_frame[b]; });
+
+            // indices shift as entries are removed, so go through ids
+            vector<uint64_t> candidate_ids;
+            candidate_ids.reserve(candidates.size());
+            for (const uint32_t index : candidates)
+            {
+                candidate_ids.emplace_back(m_resources[index]->GetObjectId());
+            }
+
+            for (const uint64_t id : candidate_ids)
+            {
+                if (!is_over_budget())
+                    break;
+
+                auto it = m_index_id.find(id);
+                evicted_entry record;
+                record.type = m_resources[it->second.index]->GetResourceType();
+                record.name = it->second.name;
+
+                // the native file was written when the resource was cached, so it can be reloaded from there
+                m_evicted_name_to_path[record.name] = it->second.path;
+                m_evicted[it->second.path]          = move(record);
+
+                shared_ptr<IResource> resource = remove_entry(it);
+                usage_cpu -= min(usage_cpu, get_size_cpu(resource.get()));
+                usage_gpu -= min(usage_gpu, get_size_gpu(resource.get()));
+                evicted.emplace_back(move(resource));
+            }
+        }
+
+        if (!evicted.empty())
+        {
+            SP_LOG_INFO("Evicted %d resources, cpu: %.2f MB, gpu: %.2f MB", static_cast<uint32_t>(evicted.size()), usage_cpu / 1048576.0, usage_gpu / 1048576.0);
+        }
+    }
+
+    void ResourceCache::SetMemoryBudget(const uint64_t budget_cpu, const uint64_t budget_gpu)
+    {
+        m_budget_cpu.store(budget_cpu, memory_order_relaxed);
+        m_budget_gpu.store(budget_gpu, memory_order_relaxed);
+    }
+
+    void ResourceCache::SetEvictionFrameThreshold(const uint32_t frame_count)
+    {
+        m_eviction_frame_threshold.store(frame_count, memory_order_relaxed);
+    }
+
+    bool ResourceCache::IsEvicted(const string& resource_file_path_native)
+    {
+        shared_lock<shared_mutex> lock(m_mutex);
+        return m_evicted.find(resource_file_path_native) != m_evicted.end();
     }
 
     vector<shared_ptr<IResource>> ResourceCache::GetByType(const ResourceType type /*= ResourceType::Unknown*/)
     {
-        lock_guard<mutex> guard(m_mutex);
+        shared_lock<shared_mutex> lock(m_mutex);
 
         vector<shared_ptr<IResource>> resources;
         for (shared_ptr<IResource>& resource : m_resources)
@@ -130,7 +492,7 @@ namespace Spartan
 
     uint64_t ResourceCache::GetMemoryUsageCpu(ResourceType type /*= Resource_Unknown*/)
     {
-        lock_guard<mutex> guard(m_mutex);
+        shared_lock<shared_mutex> lock(m_mutex);
 
         uint64_t size = 0;
         for (shared_ptr<IResource>& resource : m_resources)
@@ -149,7 +511,7 @@ namespace Spartan
 
     uint64_t ResourceCache::GetMemoryUsageGpu(ResourceType type /*= Resource_Unknown*/)
     {
-        lock_guard<mutex> guard(m_mutex);
+        shared_lock<shared_mutex> lock(m_mutex);
 
         uint64_t size = 0;
         for (shared_ptr<IResource>& resource : m_resources)
@@ -170,30 +532,30 @@ namespace Spartan
     {
         // Create resource list file
         string file_path = GetProjectDirectoryAbsolute() + World::GetName() + "_resources.dat";
-        auto file = make_unique<FileStream>(file_path, FileStream_Write);
-        if (!file->IsOpen())
+        AssetFileWriter file(file_path);
+        if (!file.IsOpen())
         {
             SP_LOG_ERROR("Failed to open file.");
             return;
         }
 
-        const uint32_t resource_count = GetResourceCount();
+        // A copy, so the cache isn't locked during file io
+        vector<shared_ptr<IResource>> resources = GetByType();
+        const uint32_t resource_count = static_cast<uint32_t>(resources.size());
 
         // Start progress report
         ProgressTracker::GetProgress(ProgressType::Resource).Start(resource_count, "Loading resources...");
 
-        // Save resource count
-        file->Write(resource_count);
-
         // Save all the currently used resources to disk
-        for (shared_ptr<IResource>& resource : m_resources)
+        vector<uint32_t> types;
+        vector<string> paths;
+        for (shared_ptr<IResource>& resource : resources)
         {
             if (!resource->HasFilePathNative())
             {
-                // Save file path
-                file->Write(resource->GetResourceFilePathNative());
-                // Save type
-                file->Write(static_cast<uint32_t>(resource->GetResourceType()));
+                types.emplace_back(static_cast<uint32_t>(resource->GetResourceType()));
+                paths.emplace_back(resource->GetResourceFilePathNative());
+
                 // Save resource (to a dedicated file)
                 resource->SaveToFile(resource->GetResourceFilePathNative());
             }
@@ -201,59 +563,83 @@ namespace Spartan
             // Update progress
             ProgressTracker::GetProgress(ProgressType::Resource).JobDone();
         }
+
+        // Save the resource list, the types first and then a path per resource
+        file.AddChunk(AssetChunkType::Resources, 0, types);
+        for (uint32_t i = 0; i < static_cast<uint32_t>(paths.size()); i++)
+        {
+            file.AddChunk(AssetChunkType::Resources, i + 1, paths[i]);
+        }
+        file.Close();
     }
 
     void ResourceCache::LoadResourcesFromFiles()
     {
-        // Open resource list file
+        // Read the resource list
         string file_path = GetProjectDirectoryAbsolute() + World::GetName() + "_resources.dat";
-        unique_ptr<FileStream> file = make_unique<FileStream>(file_path, FileStream_Read);
-        if (!file->IsOpen())
-            return;
-
-        // Load resource count
-        const uint32_t resource_count = file->ReadAs<uint32_t>();
-
-        for (uint32_t i = 0; i < resource_count; i++)
+        vector<pair<string, ResourceType>> resources;
+        AssetFileReader reader(file_path);
+        if (reader.IsOpen())
         {
-            // Load resource file path
-            string file_path = file->ReadAs<string>();
+            vector<uint32_t> types;
+            if (!reader.Read(AssetChunkType::Resources, 0, &types))
+                return;
 
-            // Load resource type
-            const ResourceType type = static_cast<ResourceType>(file->ReadAs<uint32_t>());
+            resources.resize(types.size());
+            for (uint32_t i = 0; i < static_cast<uint32_t>(types.size()); i++)
+            {
+                reader.Read(AssetChunkType::Resources, i + 1, &resources[i].first);
+                resources[i].second = static_cast<ResourceType>(types[i]);
+            }
+        }
+        else
+        {
+            // files written before the asset container
+            unique_ptr<FileStream> file = make_unique<FileStream>(file_path, FileStream_Read);
+            if (!file->IsOpen())
+                return;
 
-            switch (type)
+            resources.resize(file->ReadAs<uint32_t>());
+            for (pair<string, ResourceType>& resource : resources)
             {
-            case ResourceType::Mesh:
-                Load<Mesh>(file_path);
-                break;
-            case ResourceType::Material:
-                Load<Material>(file_path);
-                break;
-            case ResourceType::Texture:
-                Load<RHI_Texture>(file_path);
-                break;
-            case ResourceType::Texture2d:
-                Load<RHI_Texture2D>(file_path);
-                break;
-            case ResourceType::Texture2dArray:
-                Load<RHI_Texture2DArray>(file_path);
-                break;
-            case ResourceType::TextureCube:
-                Load<RHI_TextureCube>(file_path);
-                break;
-            case ResourceType::Audio:
-                Load<AudioClip>(file_path);
-                break;
+                resource.first  = file->ReadAs<string>();
+                resource.second = static_cast<ResourceType>(file->ReadAs<uint32_t>());
             }
         }
+        const uint32_t resource_count = static_cast<uint32_t>(resources.size());
+
+        // Start progress report
+        ProgressTracker::GetProgress(ProgressType::Resource).Start(resource_count, "Loading resources...");
+
+        // Load the resources in parallel, resources which depend on other resources (e.g. materials on textures)
+        // load them through Load() as well, which makes sure that the same resource is never loaded twice at the same time.
+        // This doubles as the completion barrier, all the resources are loaded once it returns.
+        auto load_resources = [&resources](uint32_t index_start, uint32_t index_end)
+        {
+            for (uint32_t i = index_start; i < index_end; i++)
+            {
+                load_by_type(resources[i].first, resources[i].second);
 
+                ProgressTracker::GetProgress(ProgressType::Resource).JobDone();
+            }
+        };
+
+        const uint32_t grain_size = 1; // resources are few and expensive
+        ThreadPool::ParallelLoop(load_resources, resource_count, grain_size);
     }
 
     void ResourceCache::Shutdown()
     {
+        unique_lock<shared_mutex> lock(m_mutex);
+
         uint32_t resource_count = static_cast<uint32_t>(m_resources.size());
         m_resources.clear();
+        m_last_used_frame.clear();
+        m_index_id.clear();
+        m_index_path.clear();
+        m_index_name.clear();
+        m_evicted.clear();
+        m_evicted_name_to_path.clear();
         SP_LOG_INFO("%d resources have been cleared", resource_count);
     }
 
@@ -312,7 +698,7 @@ namespace Spartan
         return m_resources;
     }
 
-    mutex& ResourceCache::GetMutex()
+    shared_mutex& ResourceCache::GetMutex()
     {
         return m_mutex;
     }
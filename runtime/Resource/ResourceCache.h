@@ -23,6 +23,8 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 //= INCLUDES ===============
 #include <algorithm>
+#include <functional>
+#include <shared_mutex>
 #include "IResource.h"
 #include "ProgressTracker.h"
 //==========================
@@ -48,7 +50,7 @@ namespace Spartan
         static void Shutdown();
 
         // Get by name
-        static std::shared_ptr<IResource>& GetByName(const std::string& name, ResourceType type);
+        static std::shared_ptr<IResource> GetByName(const std::string& name, ResourceType type);
         template <class T> 
         static std::shared_ptr<T> GetByName(const std::string& name) 
         { 
@@ -59,16 +61,11 @@ namespace Spartan
         static std::vector<std::shared_ptr<IResource>> GetByType(ResourceType type = ResourceType::Unknown);
 
         // Get by path
+        static std::shared_ptr<IResource> GetByPath(const std::string& path, ResourceType type);
         template <class T>
         static std::shared_ptr<T> GetByPath(const std::string& path)
         {
-            for (std::shared_ptr<IResource>& resource : GetResources())
-            {
-                if (path == resource->GetResourceFilePathNative())
-                    return std::static_pointer_cast<T>(resource);
-            }
-
-            return nullptr;
+            return std::static_pointer_cast<T>(GetByPath(path, IResource::TypeToEnum<T>()));
         }
 
         // Caches resource, or replaces with existing cached resource
@@ -93,17 +90,8 @@ namespace Spartan
                 return nullptr;
             }
 
-            // Ensure that this resource is not already cached
-            if (IsCached(resource->GetResourceFilePathNative(), resource->GetResourceType()))
-                return GetByPath<T>(resource->GetResourceFilePathNative());
-
-            std::lock_guard<std::mutex> guard(GetMutex());
-
-            // In order to guarantee deserialization, we save it now
-            resource->SaveToFile(resource->GetResourceFilePathNative());
-
-            // Cache it
-            return std::static_pointer_cast<T>(GetResources().emplace_back(resource));
+            // Cache it, unless it's already cached
+            return std::static_pointer_cast<T>(Add(resource));
         }
 
         // Loads a resource and adds it to the resource cache
@@ -116,31 +104,36 @@ namespace Spartan
                 return nullptr;
             }
 
-            // Check if the resource is already loaded
-            const std::string name = FileSystem::GetFileNameWithoutExtensionFromFilePath(file_path);
-            if (IsCached(name, IResource::TypeToEnum<T>()))
-                return GetByName<T>(name);
-
-            // Create new resource
-            std::shared_ptr<T> resource = std::make_shared<T>();
+            // Check if the resource is already loaded, resources are cached under their native file path
+            const std::string file_path_relative = FileSystem::GetRelativePath(file_path);
+            const std::string file_path_native   = FileSystem::IsEngineFile(file_path_relative) ? file_path_relative : FileSystem::NativizeFilePath(file_path_relative);
+            if (std::shared_ptr<IResource> cached = GetCached(file_path_native, IResource::TypeToEnum<T>()))
+                return std::static_pointer_cast<T>(cached);
 
-            if (flags != 0)
+            // Load it, or if another thread is already loading it, wait for that load instead
+            return std::static_pointer_cast<T>(LoadDeduplicated(file_path_native, IResource::TypeToEnum<T>(), [&file_path, flags]() -> std::shared_ptr<IResource>
             {
-                resource->SetFlags(flags);
-            }
-
-            // Set a default file path in case it's not overridden by LoadFromFile()
-            resource->SetResourceFilePath(file_path);
-
-            // Load
-            if (!resource || !resource->LoadFromFile(file_path))
-            {
-                SP_LOG_ERROR("Failed to load \"%s\".", file_path.c_str());
-                return nullptr;
-            }
-
-            // Returned cached reference which is guaranteed to be around after deserialization
-            return Cache<T>(resource);
+                // Create new resource
+                std::shared_ptr<T> resource = std::make_shared<T>();
+
+                if (flags != 0)
+                {
+                    resource->SetFlags(flags);
+                }
+
+                // Set a default file path in case it's not overridden by LoadFromFile()
+                resource->SetResourceFilePath(file_path);
+
+                // Load
+                if (!resource || !resource->LoadFromFile(file_path))
+                {
+                    SP_LOG_ERROR("Failed to load \"%s\".", file_path.c_str());
+                    return nullptr;
+                }
+
+                // Returned cached reference which is guaranteed to be around after deserialization
+                return Cache<T>(resource);
+            }));
         }
 
         template <class T>
@@ -149,19 +142,7 @@ namespace Spartan
             if (!resource)
                 return;
 
-            if (!IsCached(resource->GetObjectName(), resource->GetResourceType()))
-                return;
-
-            GetResources().erase
-            (
-                std::remove_if
-                (
-                    GetResources().begin(),
-                    GetResources().end(),
-                    [](std::shared_ptr<IResource> resource) { return dynamic_cast<SpObject*>(resource.get())->GetObjectId() == resource->GetObjectId(); }
-                ),
-                GetResources().end()
-            );
+            RemoveById(resource->GetObjectId());
         }
 
         // memory
@@ -169,6 +150,13 @@ namespace Spartan
         static uint64_t GetMemoryUsageGpu(ResourceType type = ResourceType::Unknown);
         static uint32_t GetResourceCount(ResourceType type = ResourceType::Unknown);
 
+        // eviction, resources which are only referenced by the cache are evicted (least recently used first) when
+        // the memory usage exceeds the budget, they are reloaded from their native file the next time they are requested
+        static void Tick();
+        static void SetMemoryBudget(uint64_t budget_cpu, uint64_t budget_gpu); // bytes, 0 means unlimited
+        static void SetEvictionFrameThreshold(uint32_t frame_count);            // frames a resource has to be unused before it can be evicted
+        static bool IsEvicted(const std::string& resource_file_path_native);
+
         // directories
         static void AddResourceDirectory(ResourceDirectory type, const std::string& directory);
         static std::string GetResourceDirectory(ResourceDirectory type);
@@ -179,13 +167,16 @@ namespace Spartan
 
         // misc
         static std::vector<std::shared_ptr<IResource>>& GetResources();
-        static std::mutex& GetMutex();
+        static std::shared_mutex& GetMutex();
         static bool GetUseRootShaderDirectory();
         static void SetUseRootShaderDirectory(const bool use_root_shader_directory);
 
     private:
         static bool IsCached(const uint64_t resource_id);
-        static bool IsCached(const std::string& resource_name, const ResourceType resource_type);
+        static std::shared_ptr<IResource> GetCached(const std::string& resource_file_path_native, const ResourceType resource_type);
+        static std::shared_ptr<IResource> Add(const std::shared_ptr<IResource>& resource);
+        static void RemoveById(const uint64_t resource_id);
+        static std::shared_ptr<IResource> LoadDeduplicated(const std::string& file_path_native, const ResourceType type, const std::function<std::shared_ptr<IResource>()>& load);
 
         // event handlers
         static void SaveResourcesToFiles();
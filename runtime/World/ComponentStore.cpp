@@ -0,0 +1,204 @@
+/*
+Copyright(c) 2016-2023 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+//= INCLUDES ===================
+#include "pch.h"
+#include "ComponentStore.h"
+#include "../Core/ThreadPool.h"
+//===============================
+
+//= NAMESPACES =====
+using namespace std;
+//==================
+
+namespace Spartan
+{
+    namespace
+    {
+        const uint32_t component_type_count = static_cast<uint32_t>(ComponentType::Undefined);
+        const uint32_t invalid_slot         = numeric_limits<uint32_t>::max();
+        const uint32_t blocks_per_chunk     = 256;
+        const size_t chunk_alignment        = 64;
+
+        // a pool of equally sized blocks, carved out of chunks which are never released (so addresses stay stable)
+        struct pool
+        {
+            vector<void*> chunks;
+            void* free_list = nullptr; // the first bytes of a free block point to the next free block
+        };
+
+        struct store
+        {
+            recursive_mutex components_mutex;
+            array<vector<Component*>, component_type_count> components;
+            array<atomic<uint32_t>, component_type_count> iterating = {}; // ParallelForEach() calls in flight, per type
+
+            mutex pool_mutex;
+            unordered_map<size_t, pool> pools; // keyed by block size
+        };
+
+        // intentionally never destroyed, components can outlive static destruction (e.g. when held by other statics)
+        store& get_store()
+        {
+            static store* instance = new store();
+            return *instance;
+        }
+
+        size_t get_block_size(const size_t size, const size_t alignment)
+        {
+            const size_t block_alignment = max(alignment, sizeof(void*));
+            return (max(size, sizeof(void*)) + block_alignment - 1) / block_alignment * block_alignment;
+        }
+    }
+
+    void ComponentStore::Add(Component* component)
+    {
+        SP_ASSERT(component != nullptr);
+        SP_ASSERT(component->GetType() != ComponentType::Undefined);
+
+        store& s = get_store();
+        lock_guard<recursive_mutex> lock(s.components_mutex);
+
+        if (component->m_store_slot != invalid_slot)
+            return;
+
+        vector<Component*>& components = s.components[static_cast<uint32_t>(component->GetType())];
+        component->m_store_slot        = static_cast<uint32_t>(components.size());
+        components.emplace_back(component);
+    }
+
+    void ComponentStore::Remove(Component* component)
+    {
+        SP_ASSERT(component != nullptr);
+
+        store& s = get_store();
+        lock_guard<recursive_mutex> lock(s.components_mutex);
+
+        const uint32_t slot = component->m_store_slot;
+        if (slot == invalid_slot)
+            return;
+
+        SP_ASSERT_MSG(s.iterating[static_cast<uint32_t>(component->GetType())] == 0, "Components can't be removed while ParallelForEach() iterates them");
+
+        // swap with the last one and pop, the moved component takes over the slot
+        vector<Component*>& components = s.components[static_cast<uint32_t>(component->GetType())];
+        SP_ASSERT(slot < components.size() && components[slot] == component);
+        components[slot]               = components.back();
+        components[slot]->m_store_slot = slot;
+        components.pop_back();
+
+        component->m_store_slot = invalid_slot;
+    }
+
+    uint32_t ComponentStore::GetCount(const ComponentType type)
+    {
+        store& s = get_store();
+        lock_guard<recursive_mutex> lock(s.components_mutex);
+
+        return static_cast<uint32_t>(s.components[static_cast<uint32_t>(type)].size());
+    }
+
+    void ComponentStore::ParallelForEach(const ComponentType type, const function<void(Component*)>& function, const uint32_t grain_size)
+    {
+        store& s = get_store();
+
+        // iterate a snapshot and don't hold the lock across the loop, so that the function (or anything it waits on)
+        // can add components, which would otherwise reallocate the array (or deadlock when done from another thread)
+        vector<Component*> components;
+        {
+            lock_guard<recursive_mutex> lock(s.components_mutex);
+            components = GetComponents(type);
+        }
+
+        atomic<uint32_t>& iterating = s.iterating[static_cast<uint32_t>(type)];
+        iterating++;
+        ThreadPool::ParallelLoop([&components, &function](uint32_t index_start, uint32_t index_end)
+        {
+            for (uint32_t i = index_start; i < index_end; i++)
+            {
+                function(components[i]);
+            }
+        }, static_cast<uint32_t>(components.size()), grain_size);
+        iterating--;
+    }
+
+    recursive_mutex& ComponentStore::GetMutex()
+    {
+        return get_store().components_mutex;
+    }
+
+    const vector<Component*>& ComponentStore::GetComponents(const ComponentType type)
+    {
+        SP_ASSERT(type != ComponentType::Undefined);
+        return get_store().components[static_cast<uint32_t>(type)];
+    }
+
+    void* ComponentStore::PoolAllocate(const size_t size, const size_t alignment)
+    {
+        // not worth pooling, and the chunks wouldn't satisfy the alignment
+        if (alignment > chunk_alignment)
+            return ::operator new(size, align_val_t(alignment));
+
+        const size_t block_size = get_block_size(size, alignment);
+
+        store& s = get_store();
+        lock_guard<mutex> lock(s.pool_mutex);
+        pool& p = s.pools[block_size];
+
+        if (!p.free_list)
+        {
+            byte* chunk = static_cast<byte*>(::operator new(block_size * blocks_per_chunk, align_val_t(chunk_alignment)));
+            p.chunks.emplace_back(chunk);
+
+            // thread the new blocks into the free list, in address order
+            for (uint32_t i = blocks_per_chunk; i-- > 0;)
+            {
+                void* block                 = chunk + i * block_size;
+                *static_cast<void**>(block) = p.free_list;
+                p.free_list                 = block;
+            }
+        }
+
+        void* block = p.free_list;
+        p.free_list = *static_cast<void**>(block);
+
+        return block;
+    }
+
+    void ComponentStore::PoolFree(void* data, const size_t size, const size_t alignment)
+    {
+        if (!data)
+            return;
+
+        if (alignment > chunk_alignment)
+        {
+            ::operator delete(data, align_val_t(alignment));
+            return;
+        }
+
+        store& s = get_store();
+        lock_guard<mutex> lock(s.pool_mutex);
+        pool& p = s.pools[get_block_size(size, alignment)];
+
+        *static_cast<void**>(data) = p.free_list;
+        p.free_list                = data;
+    }
+}
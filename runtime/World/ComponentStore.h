@@ -0,0 +1,91 @@
+/*
+Copyright(c) 2016-2023 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+//= INCLUDES ===================
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <functional>
+#include "Components/Component.h"
+//==============================
+
+namespace Spartan
+{
+    // Components of the same type, packed into one array (a sparse set, each component knows its slot), so that systems
+    // can iterate them linearly, instead of walking every entity and every one of its component slots. Components are
+    // also allocated from per-size pools, so the ones that are iterated together are close in memory as well.
+    // Entity::GetComponent<T>() keeps working as before, iterating through the store is opt-in.
+    class SP_CLASS ComponentStore
+    {
+    public:
+        static void Add(Component* component);
+        static void Remove(Component* component);
+        static uint32_t GetCount(ComponentType type);
+
+        // Calls function(Component*) for every component of the given type, components added in the meantime are visited too
+        template<typename Function>
+        static void ForEach(const ComponentType type, Function&& function)
+        {
+            std::lock_guard<std::recursive_mutex> lock(GetMutex());
+
+            const std::vector<Component*>& components = GetComponents(type);
+            for (uint32_t i = 0; i < static_cast<uint32_t>(components.size()); i++)
+            {
+                function(components[i]);
+            }
+        }
+
+        // Like ForEach() but spread across the thread pool, the function must only write to the component it's given.
+        // The components are iterated from a snapshot, ones added in the meantime aren't visited, removing any is an error.
+        static void ParallelForEach(ComponentType type, const std::function<void(Component*)>& function, uint32_t grain_size = 64);
+
+        // Allocates the component (and the shared pointer's control block) from the pools
+        template<typename T, typename... Args>
+        static std::shared_ptr<T> AllocateShared(Args&&... args)
+        {
+            return std::allocate_shared<T>(PoolAllocator<T>(), std::forward<Args>(args)...);
+        }
+
+        static void* PoolAllocate(size_t size, size_t alignment);
+        static void PoolFree(void* data, size_t size, size_t alignment);
+
+    private:
+        template<typename T>
+        struct PoolAllocator
+        {
+            using value_type = T;
+
+            PoolAllocator() = default;
+            template<typename U> PoolAllocator(const PoolAllocator<U>&) {}
+
+            T* allocate(size_t count)               { return static_cast<T*>(PoolAllocate(count * sizeof(T), alignof(T))); }
+            void deallocate(T* data, size_t count)  { PoolFree(data, count * sizeof(T), alignof(T)); }
+
+            template<typename U> bool operator==(const PoolAllocator<U>&) const { return true; }
+            template<typename U> bool operator!=(const PoolAllocator<U>&) const { return false; }
+        };
+
+        static std::recursive_mutex& GetMutex();
+        static const std::vector<Component*>& GetComponents(ComponentType type);
+    };
+}
@@ -119,6 +119,7 @@ namespace Spartan
         // Frustum
         bool IsInViewFrustum(std::shared_ptr<Renderable> renderable) const;
         bool IsInViewFrustum(const Math::Vector3& center, const Math::Vector3& extents) const;
+        const Math::Frustum& GetFrustum() const { return m_frustum; }
 
         // Bookmarks
         void AddBookmark(camera_bookmark bookmark)               { m_bookmarks.emplace_back(bookmark); };
@@ -33,6 +33,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "Terrain.h"
 #include "ReflectionProbe.h"
 #include "../Entity.h"
+#include "../ComponentStore.h"
 //==========================
 
 //= NAMESPACES =====
@@ -48,6 +49,12 @@ namespace Spartan
         m_enabled         = true;
     }
 
+    Component::~Component()
+    {
+        // in case the component outlived its entity, or was never removed from it
+        ComponentStore::Remove(this);
+    }
+
     template <typename T>
     inline constexpr ComponentType Component::TypeToEnum() { return ComponentType::Undefined; }
 
@@ -27,6 +27,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include <any>
 #include <vector>
 #include <functional>
+#include <limits>
 #include "../../Core/SpObject.h"
 //===============================
 
@@ -61,7 +62,7 @@ namespace Spartan
     {
     public:
         Component(std::weak_ptr<Entity> entity);
-        virtual ~Component() = default;
+        virtual ~Component();
 
         // Runs when the component gets added
         virtual void OnInitialize() {}
@@ -139,7 +140,11 @@ namespace Spartan
         Entity* m_entity_ptr = nullptr;
 
     private:
+        friend class ComponentStore;
+
         // The attributes of the component
         std::vector<Attribute> m_attributes;
+        // The slot of the component in the ComponentStore
+        uint32_t m_store_slot = std::numeric_limits<uint32_t>::max();
     };
 }
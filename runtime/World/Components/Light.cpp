@@ -412,10 +412,13 @@ namespace Spartan
 
     bool Light::IsInViewFrustum(shared_ptr<Renderable> renderable, uint32_t index) const
     {
-        const BoundingBox box = renderable->GetBoundingBox();
-        const Vector3 center  = box.GetCenter();
-        const Vector3 extents = box.GetExtents();
+        const BoundingBox& box = renderable->GetBoundingBox();
 
+        return IsInViewFrustum(box.GetCenter(), box.GetExtents(), index);
+    }
+
+    bool Light::IsInViewFrustum(const Vector3& center, const Vector3& extents, const uint32_t index) const
+    {
         // ensure that potential shadow casters from behind the near plane are not rejected
         const bool ignore_near_plane = (m_light_type == LightType::Directional) ? true : false;
 
@@ -122,6 +122,8 @@ namespace Spartan
         void CreateShadowMap();
 
         bool IsInViewFrustum(std::shared_ptr<Renderable> renderable, const uint32_t index) const;
+        bool IsInViewFrustum(const Math::Vector3& center, const Math::Vector3& extents, const uint32_t index) const;
+        const Math::Frustum& GetFrustum(const uint32_t index) const { return m_frustums[index]; }
 
     private:
         void ComputeViewMatrix();
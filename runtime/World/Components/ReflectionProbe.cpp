@@ -132,10 +132,13 @@ namespace Spartan
 
     bool ReflectionProbe::IsInViewFrustum(shared_ptr<Renderable> renderable, uint32_t index) const
     {
-        const auto box     = renderable->GetBoundingBox();
-        const auto center  = box.GetCenter();
-        const auto extents = box.GetExtents();
+        const auto& box = renderable->GetBoundingBox();
 
+        return IsInViewFrustum(box.GetCenter(), box.GetExtents(), index);
+    }
+
+    bool ReflectionProbe::IsInViewFrustum(const Vector3& center, const Vector3& extents, const uint32_t index) const
+    {
         return m_frustum[index].IsVisible(center, extents);
     }
 
@@ -43,6 +43,8 @@ namespace Spartan
 
         // Returns true if the entity (renderable) is within the view frustum of a particular face (index) of the probe.
         bool IsInViewFrustum(std::shared_ptr<Renderable> renderable, uint32_t index) const;
+        bool IsInViewFrustum(const Math::Vector3& center, const Math::Vector3& extents, uint32_t index) const;
+        const Math::Frustum& GetFrustum(const uint32_t index) const { return m_frustum[index]; }
 
         // Properties
         RHI_Texture* GetColorTexture()                    { return m_texture_color.get(); }
@@ -24,6 +24,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "Renderable.h"
 #include "Transform.h"
 #include "../Rendering/Renderer.h"
+#include "../Rendering/Mesh.h"
 #include "../RHI/RHI_VertexBuffer.h"
 #include "../../IO/FileStream.h"
 #include "../../Resource/ResourceCache.h"
@@ -36,10 +37,50 @@ using namespace Spartan::Math;
 
 namespace Spartan
 {
+    namespace
+    {
+        // the screen size (the bounding sphere's radius over the half height of the view) below which each lod is used
+        const array<float, mesh_lod_count - 1> lod_screen_sizes = { 0.25f, 0.1f, 0.04f };
+        // how far past a threshold the size has to go before the lod changes, so that objects near one don't flicker
+        const float lod_hysteresis = 0.1f;
+
+        float screen_size(const BoundingBox& box, const Vector3& camera_position, const float tan_half_fov)
+        {
+            const float radius   = box.GetExtents().Length();
+            const float distance = Vector3::Distance(box.GetCenter(), camera_position);
+
+            // inside the bounding sphere, as big as it gets
+            if (distance <= radius)
+                return numeric_limits<float>::max();
+
+            return radius / (distance * tan_half_fov);
+        }
+
+        uint32_t lod_select(const float size, const uint32_t lod_current)
+        {
+            // the thresholds get smaller with each lod, so the lod is the number of them the size is below
+            uint32_t lod_coarser = 0;
+            uint32_t lod_finer   = 0;
+            for (const float threshold : lod_screen_sizes)
+            {
+                lod_coarser += size < threshold * (1.0f - lod_hysteresis) ? 1 : 0;
+                lod_finer   += size < threshold * (1.0f + lod_hysteresis) ? 1 : 0;
+            }
+
+            if (lod_coarser > lod_current)
+                return lod_coarser;
+
+            if (lod_finer < lod_current)
+                return lod_finer;
+
+            return lod_current;
+        }
+    }
+
     Renderable::Renderable(weak_ptr<Entity> entity) : Component(entity)
     {
         SP_REGISTER_ATTRIBUTE_VALUE_VALUE(m_material_default,       bool);
-        SP_REGISTER_ATTRIBUTE_VALUE_VALUE(m_material,               Material*);
+        SP_REGISTER_ATTRIBUTE_VALUE_VALUE(m_material,               shared_ptr<Material>);
         SP_REGISTER_ATTRIBUTE_VALUE_VALUE(m_cast_shadows,           bool);
         SP_REGISTER_ATTRIBUTE_VALUE_VALUE(m_geometry_index_offset,  uint32_t);
         SP_REGISTER_ATTRIBUTE_VALUE_VALUE(m_geometry_index_count,   uint32_t);
@@ -96,7 +137,7 @@ namespace Spartan
         {
             string material_name;
             stream->Read(&material_name);
-            m_material = ResourceCache::GetByName<Material>(material_name).get();
+            m_material = ResourceCache::GetByName<Material>(material_name);
         }
     }
 
@@ -153,14 +194,17 @@ namespace Spartan
         // either the bounding box is dirty, or the transform has changed, or the instances have changed
         if (m_bounding_box_dirty || m_last_transform != GetTransform()->GetMatrix())
         {
-            m_bounding_box = m_bounding_box_mesh.Transform(GetTransform()->GetMatrix());
+            const Matrix& transform = GetTransform()->GetMatrix();
+            m_bounding_box          = m_instances.empty() ? m_bounding_box_mesh.Transform(transform) : BoundingBox::Undefined;
 
-            // loop through each instance and expand the bounding box
-            for (const Matrix& instance_transform : m_instances)
+            // each instance is transformed by the entity first, then by the instance transform (like the shaders do),
+            // the bounding box covers all of them, so that whole renderables can be culled before their instances are
+            m_bounding_box_instances.resize(m_instances.size());
+            for (uint32_t i = 0; i < static_cast<uint32_t>(m_instances.size()); i++)
             {
                 // the instance transforms are transposed (see terrain.cpp), so we need to transpose them back
-                Matrix transposed = instance_transform.Transposed();
-                m_bounding_box.Merge(m_bounding_box_mesh.Transform(Matrix::CreateTranslation(transposed.GetTranslation())));
+                m_bounding_box_instances[i] = m_bounding_box_mesh.Transform(transform * m_instances[i].Transposed());
+                m_bounding_box.Merge(m_bounding_box_instances[i]);
             }
 
             m_last_transform     = GetTransform()->GetMatrix();
@@ -171,6 +215,40 @@ namespace Spartan
     }
 
 
+    void Renderable::UpdateLods(const Vector3& camera_position, const float camera_fov_vertical_rad)
+    {
+        m_lods_instances.resize(m_instances.size(), 0);
+
+        if (!m_mesh || !m_mesh->HasLods())
+        {
+            m_lod = 0;
+            fill(m_lods_instances.begin(), m_lods_instances.end(), static_cast<uint8_t>(0));
+            return;
+        }
+
+        const float tan_half_fov = tan(camera_fov_vertical_rad * 0.5f);
+        if (HasInstancing())
+        {
+            const vector<BoundingBox>& boxes = GetBoundingBoxInstances();
+            for (uint32_t i = 0; i < static_cast<uint32_t>(boxes.size()); i++)
+            {
+                m_lods_instances[i] = static_cast<uint8_t>(lod_select(screen_size(boxes[i], camera_position, tan_half_fov), m_lods_instances[i]));
+            }
+        }
+        else
+        {
+            m_lod = lod_select(screen_size(GetBoundingBox(), camera_position, tan_half_fov), m_lod);
+        }
+    }
+
+    MeshLod Renderable::GetLodIndexRange(const uint32_t lod) const
+    {
+        if (!m_mesh)
+            return { m_geometry_index_offset, m_geometry_index_count };
+
+        return m_mesh->GetLod(m_geometry_index_offset, m_geometry_index_count, lod);
+    }
+
     const Spartan::Math::BoundingBox Renderable::GetBoundingBoxNoInstancing()
     {
         return m_bounding_box_mesh.Transform(GetTransform()->GetMatrix());
@@ -183,7 +261,7 @@ namespace Spartan
         // in order for the component to guarantee serialization/deserialization, we cache the material
         shared_ptr<Material> _material = ResourceCache::Cache(material);
 
-        m_material = _material.get();
+        m_material = _material;
 
         // set to false otherwise material won't serialize/deserialize
         m_material_default = false;
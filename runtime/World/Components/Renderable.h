@@ -32,6 +32,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 namespace Spartan
 {
     class Mesh;
+    struct MeshLod;
     class Material;
     class RHI_VertexBuffer;
 
@@ -65,6 +66,7 @@ namespace Spartan
         // bounding box
         const Math::BoundingBox& GetBoundingBox();
         const Math::BoundingBox GetBoundingBoxNoInstancing();
+        const std::vector<Math::BoundingBox>& GetBoundingBoxInstances() { GetBoundingBox(); return m_bounding_box_instances; }
 
         //= MATERIAL ====================================================================
         // Sets a material from memory (adds it to the resource cache by default)
@@ -75,7 +77,7 @@ namespace Spartan
 
         void SetDefaultMaterial();
         std::string GetMaterialName() const;
-        Material* GetMaterial()       const { return m_material; }
+        Material* GetMaterial()       const { return m_material.get(); }
         auto HasMaterial()            const { return m_material != nullptr; }
         //===============================================================================
 
@@ -87,8 +89,15 @@ namespace Spartan
         bool HasInstancing()                  const { return !m_instances.empty(); }
         RHI_VertexBuffer* GetInstanceBuffer() const { return m_instance_buffer.get(); }
         uint32_t GetInstanceCount()           const { return static_cast<uint32_t>(m_instances.size()); }
+        const std::vector<Math::Matrix>& GetInstances() const { return m_instances; }
         void SetInstances(const std::vector<Math::Matrix>& instances);
 
+        // lods, picked from the size on screen (as seen from the camera) and used by every view, so shadows match
+        void UpdateLods(const Math::Vector3& camera_position, const float camera_fov_vertical_rad);
+        uint32_t GetLod() const                              { return m_lod; }
+        const std::vector<uint8_t>& GetLodsInstances() const { return m_lods_instances; }
+        MeshLod GetLodIndexRange(const uint32_t lod) const;
+
     private:
         // geometry/mesh
         uint32_t m_geometry_index_offset  = 0;
@@ -102,12 +111,17 @@ namespace Spartan
 
         // material
         bool m_material_default = false;
-        Material* m_material    = nullptr;
+        std::shared_ptr<Material> m_material; // shared, so that the resource cache can tell when a material is in use
 
         // instancing
         std::vector<Math::Matrix> m_instances;
+        std::vector<Math::BoundingBox> m_bounding_box_instances; // world space, one per instance
         std::shared_ptr<RHI_VertexBuffer> m_instance_buffer;
 
+        // lods
+        uint32_t m_lod = 0;
+        std::vector<uint8_t> m_lods_instances; // one per instance
+
         // misc
         Math::Matrix m_last_transform = Math::Matrix::Identity;
         bool m_cast_shadows = true;
@@ -246,17 +246,16 @@ namespace Spartan
                 }
             };
 
+            // vertices are cheap to process but there are a lot of them, so claim them in chunks to avoid long tails
             uint32_t vertex_count = static_cast<uint32_t>(vertices.size());
-            ThreadPool::ParallelLoop(compute_vertex_normals_tangents, vertex_count);
+            uint32_t grain_size   = 2048;
+            ThreadPool::ParallelLoop(compute_vertex_normals_tangents, vertex_count, grain_size);
         }
 
-        float get_random_float(float x, float y)
+        float get_random_float(mt19937& generator, float x, float y)
         {
-            random_device rd;                        // obtain a random number from hardware
-            mt19937 gen(rd());                       // seed the generator
-            uniform_real_distribution<> distr(x, y); // define the distribution
-
-            return static_cast<float>(distr(gen));
+            uniform_real_distribution<> distr(x, y);
+            return static_cast<float>(distr(generator));
         }
 
         vector<Matrix> generate_transforms(
@@ -266,12 +265,13 @@ namespace Spartan
             float max_slope_radians,
             bool rotate_to_match_surface_normal,
             float water_level,
-            float terrain_offset
+            float terrain_offset,
+            uint32_t seed
         )
         {
+            // each job has its own generator (rand() isn't thread safe), seeded so that the placement is deterministic
             vector<Matrix> transforms;
-            random_device seed;
-            mt19937 generator(seed());
+            mt19937 generator(seed);
             uniform_int_distribution<> distribution(0, static_cast<int>(indices.size() / 3 - 1));
 
             for (uint32_t i = 0; i < tree_count; ++i)
@@ -293,8 +293,8 @@ namespace Spartan
                 if (is_relatively_flat && is_above_water)
                 {
                     // generate barycentric coordinates
-                    float u = static_cast<float>(rand()) / static_cast<float>(RAND_MAX);
-                    float v = static_cast<float>(rand()) / static_cast<float>(RAND_MAX);
+                    float u = get_random_float(generator, 0.0f, 1.0f);
+                    float v = get_random_float(generator, 0.0f, 1.0f);
                     if (u + v > 1.0f)
                     {
                         u = 1.0f - u;
@@ -302,14 +302,14 @@ namespace Spartan
                     }
 
                     // scale is a random value between 0.5 and 1.5
-                    Vector3 scale = Vector3(get_random_float(0.5f, 1.5f));
+                    Vector3 scale = Vector3(get_random_float(generator, 0.5f, 1.5f));
 
                     // position is the barycentric coordinates multiplied by the vertices of the triangle, plus a terrain_offset to avoid floating object
                     Vector3 position = v0 + (u * (v1 - v0) + terrain_offset) + v * (v2 - v0);
 
                     // rotation is a random rotation around the Y axis, and then rotated to match the normal of the triangle
                     Quaternion rotate_to_normal = rotate_to_match_surface_normal ? Quaternion::FromToRotation(Vector3::Up, normal) : Quaternion::Identity;
-                    Quaternion rotation         = rotate_to_normal * Quaternion::FromEulerAngles(0.0f, get_random_float(0.0f, 360.0f), 0.0f);
+                    Quaternion rotation         = rotate_to_normal * Quaternion::FromEulerAngles(0.0f, get_random_float(generator, 0.0f, 360.0f), 0.0f);
 
                     // we are mapping 4 vector4 (c++ side, see vulka_pipeline.cpp) to 1 matrix (HLSL side), and the matrix
                     // memory layout is column-major, so we need to transpose to get it as row-major
@@ -383,20 +383,35 @@ namespace Spartan
             return;
         }
 
-        ThreadPool::AddTask([this, on_complete]()
-        {
-            m_is_generating = true;
+        m_is_generating = true;
 
+        // data shared by the jobs below
+        struct generation_data
+        {
+            vector<Vector3> positions;
+            vector<RHI_Vertex_PosTexNorTan> vertices;
+            vector<uint32_t> indices;
+            uint32_t width  = 0;
+            uint32_t height = 0;
+            bool failed     = false;
+            function<void()> on_complete; // kept here, as it's too big for a job's inline capture storage
+        };
+        shared_ptr<generation_data> data = make_shared<generation_data>();
+        data->on_complete                = move(on_complete);
+
+        // 1. generate positions by reading the height map
+        JobHandle job_positions = ThreadPool::CreateJob([this, data]()
+        {
             if (!load_and_normalize_height_data(m_height_data, m_height_texture, m_min_y, m_max_y))
             {
-                m_is_generating = false;
+                data->failed = true;
                 return;
             }
 
             // deduce some stuff
-            uint32_t width   = m_height_texture->GetWidth();
-            uint32_t height  = m_height_texture->GetHeight();
-            m_height_samples = width * height;
+            data->width      = m_height_texture->GetWidth();
+            data->height     = m_height_texture->GetHeight();
+            m_height_samples = data->width * data->height;
             m_vertex_count   = m_height_samples;
             m_index_count    = m_vertex_count * 6;
             m_triangle_count = m_index_count / 3;
@@ -411,57 +426,102 @@ namespace Spartan
             ProgressTracker::GetProgress(ProgressType::Terrain).Start(job_count, "Generating terrain...");
 
             // pre-allocate memory for the calculations that follow
-            vector<Vector3> positions(m_height_samples);
-            positions.reserve(m_height_samples);
-            vector<RHI_Vertex_PosTexNorTan> vertices(m_vertex_count);
-            vertices.reserve(m_vertex_count);
-            vector<uint32_t> indices(m_index_count);
-            indices.reserve(m_index_count);
-
-            // 1. generate positions by reading the height map
+            data->positions = vector<Vector3>(m_height_samples);
+            data->vertices  = vector<RHI_Vertex_PosTexNorTan>(m_vertex_count);
+            data->indices   = vector<uint32_t>(m_index_count);
+
             ProgressTracker::GetProgress(ProgressType::Terrain).SetText("Generating positions...");
-            generate_positions(positions, m_height_data, width, height);
+            generate_positions(data->positions, m_height_data, data->width, data->height);
             ProgressTracker::GetProgress(ProgressType::Terrain).JobDone();
+        });
+
+        // 2. compute vertices and indices
+        JobHandle job_vertices = ThreadPool::CreateJob([data]()
+        {
+            if (data->failed)
+                return;
 
-            // 2. compute vertices and indices
             ProgressTracker::GetProgress(ProgressType::Terrain).SetText("Generating vertices and indices...");
-            generate_vertices_and_indices(vertices, indices, positions, width, height);
+            generate_vertices_and_indices(data->vertices, data->indices, data->positions, data->width, data->height);
             ProgressTracker::GetProgress(ProgressType::Terrain).JobDone();
+        });
+
+        // 3. compute normals and tangents
+        JobHandle job_normals = ThreadPool::CreateJob([data]()
+        {
+            if (data->failed)
+                return;
 
-            // 3. compute normals and tangents
             ProgressTracker::GetProgress(ProgressType::Terrain).SetText("Generating normals...");
-            generate_normals(indices, vertices);
+            generate_normals(data->indices, data->vertices);
             // jobs done are tracked internally here because this is the most expensive function
+        });
+
+        // 4. create mesh
+        JobHandle job_mesh = ThreadPool::CreateJob([this, data]()
+        {
+            if (data->failed)
+                return;
 
-            // 4. create mesh
             ProgressTracker::GetProgress(ProgressType::Terrain).SetText("Creating mesh...");
-            UpdateFromVertices(indices, vertices);
+            UpdateFromVertices(data->indices, data->vertices);
             ProgressTracker::GetProgress(ProgressType::Terrain).JobDone();
+        });
+
+        // 4. compute tree positions (independent from the mesh creation)
+        JobHandle job_trees = ThreadPool::CreateJob([this, data]()
+        {
+            if (data->failed)
+                return;
 
-            // compute tree positions
             uint32_t tree_count              = 5000;
             float max_slope                  = 30.0f * Math::Helper::DEG_TO_RAD;
             bool rotate_match_surface_normal = false; // trees tend to grow upwards (they go for the sun)
             float terrain_offset             = -0.2f;
-            m_trees                          = generate_transforms(vertices, indices, tree_count, max_slope, rotate_match_surface_normal, m_water_level, terrain_offset);
-
-            // compute plant 1 positions
-            uint32_t plant_count        = 20000;
-            max_slope                   = 40.0f * Math::Helper::DEG_TO_RAD;
-            rotate_match_surface_normal = true; // small plants tend to grow towards the sun but they can have some wonky angles due to low mass
-            terrain_offset              = 0.0f;
-            m_plants_1                  = generate_transforms(vertices, indices, plant_count, max_slope, rotate_match_surface_normal, m_water_level, terrain_offset);
+            uint32_t seed                    = 1;
+            m_trees                          = generate_transforms(data->vertices, data->indices, tree_count, max_slope, rotate_match_surface_normal, m_water_level, terrain_offset, seed);
+        });
 
-            // compute plant 2 positions
-            m_plants_2 = generate_transforms(vertices, indices, plant_count, max_slope, rotate_match_surface_normal, m_water_level, terrain_offset);
+        // 4. compute plant positions (independent from the mesh creation)
+        auto generate_plants = [this, data](vector<Matrix>& transforms, uint32_t seed)
+        {
+            if (data->failed)
+                return;
 
-            if (on_complete)
+            uint32_t plant_count             = 20000;
+            float max_slope                  = 40.0f * Math::Helper::DEG_TO_RAD;
+            bool rotate_match_surface_normal = true; // small plants tend to grow towards the sun but they can have some wonky angles due to low mass
+            float terrain_offset             = 0.0f;
+            transforms                       = generate_transforms(data->vertices, data->indices, plant_count, max_slope, rotate_match_surface_normal, m_water_level, terrain_offset, seed);
+        };
+        JobHandle job_plants_1 = ThreadPool::CreateJob([this, generate_plants]() { generate_plants(m_plants_1, 2); });
+        JobHandle job_plants_2 = ThreadPool::CreateJob([this, generate_plants]() { generate_plants(m_plants_2, 3); });
+
+        // 5. done
+        JobHandle job_complete = ThreadPool::CreateJob([this, data]()
+        {
+            if (!data->failed && data->on_complete)
             {
-                on_complete();
+                data->on_complete();
             }
 
             m_is_generating = false;
         });
+
+        // wire up the graph
+        ThreadPool::AddContinuation(job_positions, job_vertices);
+        ThreadPool::AddContinuation(job_vertices,  job_normals);
+        for (const JobHandle& job : { job_mesh, job_trees, job_plants_1, job_plants_2 })
+        {
+            ThreadPool::AddContinuation(job_normals, job);
+            ThreadPool::AddContinuation(job, job_complete);
+        }
+
+        // run it
+        for (const JobHandle& job : { job_complete, job_mesh, job_trees, job_plants_1, job_plants_2, job_normals, job_vertices, job_positions })
+        {
+            ThreadPool::Run(job);
+        }
     }
 
     void Terrain::UpdateFromMesh(const shared_ptr<Mesh> mesh) const
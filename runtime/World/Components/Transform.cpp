@@ -25,6 +25,8 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "../World.h"
 #include "../Entity.h"
 #include "../../IO/FileStream.h"
+#include "../../Core/ThreadPool.h"
+#include "../../Profiling/Profiler.h"
 //==============================
 
 //= NAMESPACES ================
@@ -34,6 +36,38 @@ using namespace Spartan::Math;
 
 namespace Spartan
 {
+    namespace
+    {
+        const uint32_t invalid_index = numeric_limits<uint32_t>::max();
+
+        // The hierarchy in structure of arrays form, sorted by depth (breadth-first), so that parents always come before
+        // their children and every level can be updated in parallel once the level above it is done.
+        struct transform_hierarchy
+        {
+            vector<Transform*> nodes;
+            vector<uint32_t> parents;       // index of the parent, invalid_index for roots
+            vector<Matrix> world;           // world matrices, so that children read their parent's from contiguous memory
+            vector<uint8_t> changed;        // what changed (change_* flags) during this pass, children have to follow
+            vector<uint32_t> level_offsets; // level i spans [level_offsets[i], level_offsets[i + 1])
+        };
+
+        transform_hierarchy hierarchy;
+        atomic<bool> hierarchy_dirty = true; // the structure has to be rebuilt (a transform was added, removed or re-parented)
+
+        enum change_flags : uint8_t
+        {
+            change_position = 1 << 0,
+            change_rotation = 1 << 1,
+            change_scale    = 1 << 2,
+            change_all      = change_position | change_rotation | change_scale
+        };
+
+        void mark_hierarchy_dirty()
+        {
+            hierarchy_dirty = true;
+        }
+    }
+
     Transform::Transform(weak_ptr<Entity> entity) : Component(entity)
     {
         m_position_local  = Vector3::Zero;
@@ -50,6 +84,13 @@ namespace Spartan
         SP_REGISTER_ATTRIBUTE_VALUE_VALUE(m_scale_local,    Vector3);
         SP_REGISTER_ATTRIBUTE_VALUE_VALUE(m_matrix,         Matrix);
         SP_REGISTER_ATTRIBUTE_VALUE_VALUE(m_matrix_local,   Matrix);
+
+        mark_hierarchy_dirty();
+    }
+
+    Transform::~Transform()
+    {
+        mark_hierarchy_dirty();
     }
 
     void Transform::OnInitialize()
@@ -61,15 +102,105 @@ namespace Spartan
 
     void Transform::OnTick()
     {
-        if (!m_is_dirty)
-            return;
+        // resolved by UpdateHierarchy(), for all transforms at once
+    }
 
-        UpdateTransform();
+    void Transform::UpdateHierarchy(const vector<shared_ptr<Entity>>& entities)
+    {
+        SP_PROFILE_FUNCTION();
+
+        // rebuild, breadth-first
+        if (hierarchy_dirty.exchange(false))
+        {
+            hierarchy.nodes.clear();
+            hierarchy.parents.clear();
+            hierarchy.level_offsets.clear();
+            hierarchy.level_offsets.emplace_back(0);
+
+            for (const shared_ptr<Entity>& entity : entities)
+            {
+                Transform* transform = entity ? entity->GetTransform().get() : nullptr;
+                if (transform && !transform->HasParent())
+                {
+                    hierarchy.nodes.emplace_back(transform);
+                    hierarchy.parents.emplace_back(invalid_index);
+                }
+            }
+
+            uint32_t level_start = 0;
+            while (level_start < static_cast<uint32_t>(hierarchy.nodes.size()))
+            {
+                const uint32_t level_end = static_cast<uint32_t>(hierarchy.nodes.size());
+                hierarchy.level_offsets.emplace_back(level_end);
+
+                for (uint32_t i = level_start; i < level_end; i++)
+                {
+                    for (Transform* child : hierarchy.nodes[i]->m_children)
+                    {
+                        hierarchy.nodes.emplace_back(child);
+                        hierarchy.parents.emplace_back(i);
+                    }
+                }
+
+                level_start = level_end;
+            }
+
+            // re-parented transforms are marked dirty, so they (and their descendants) get resolved below
+            hierarchy.world.resize(hierarchy.nodes.size());
+            hierarchy.changed.resize(hierarchy.nodes.size());
+        }
+
+        // update, level by level
+        auto update_nodes = [](uint32_t index_start, uint32_t index_end)
+        {
+            for (uint32_t i = index_start; i < index_end; i++)
+            {
+                Transform* transform  = hierarchy.nodes[i];
+                const uint32_t parent = hierarchy.parents[i];
+
+                // a change of the parent's world matrix (e.g. a rotation) carries over to the child's
+                uint8_t changes = parent != invalid_index ? hierarchy.changed[parent] : 0;
+                if (transform->m_is_dirty)
+                {
+                    // without pending changes, the transform was re-parented, which can change anything
+                    changes |= transform->m_changes_pending != 0 ? transform->m_changes_pending : static_cast<uint8_t>(change_all);
+                }
+
+                transform->m_position_changed_this_frame = (changes & change_position) != 0;
+                transform->m_rotation_changed_this_frame = (changes & change_rotation) != 0;
+                transform->m_scale_changed_this_frame    = (changes & change_scale)    != 0;
+                transform->m_is_dirty                    = false;
+                transform->m_changes_pending             = 0;
+                hierarchy.changed[i]                     = changes;
+
+                if (changes == 0)
+                {
+                    hierarchy.world[i] = transform->m_matrix;
+                    continue;
+                }
+
+                transform->m_matrix_local = Matrix(transform->m_position_local, transform->m_rotation_local, transform->m_scale_local);
+                transform->m_matrix       = parent != invalid_index ? transform->m_matrix_local * hierarchy.world[parent] : transform->m_matrix_local;
+                hierarchy.world[i]        = transform->m_matrix;
+            }
+        };
+
+        const uint32_t grain_size = 256; // small levels (e.g. the few parts of a car) are cheaper to do inline
+        for (uint32_t level = 0; level + 1 < static_cast<uint32_t>(hierarchy.level_offsets.size()); level++)
+        {
+            const uint32_t level_start = hierarchy.level_offsets[level];
+            const uint32_t level_count = hierarchy.level_offsets[level + 1] - level_start;
 
-        m_is_dirty                    = false;
-        m_position_changed_this_frame = false;
-        m_rotation_changed_this_frame = true;
-        m_scale_changed_this_frame    = true;
+            ThreadPool::ParallelLoop([level_start, &update_nodes](uint32_t index_start, uint32_t index_end)
+            {
+                update_nodes(level_start + index_start, level_start + index_end);
+            }, level_count, grain_size);
+        }
+    }
+
+    void Transform::MarkHierarchyDirty()
+    {
+        mark_hierarchy_dirty();
     }
 
     void Transform::Serialize(FileStream* stream)
@@ -101,29 +232,37 @@ namespace Spartan
             }
         }
 
-        UpdateTransform();
+        m_is_dirty         = true;
+        m_changes_pending |= change_all;
     }
 
-    void Transform::UpdateTransform()
+    Matrix Transform::GetMatrix() const
     {
-        // Compute local transform
-        m_matrix_local = Matrix(m_position_local, m_rotation_local, m_scale_local);
-
-        // Compute world transform
-        if (m_parent)
+        // nothing is written here, so reads are safe from any thread while the hierarchy pass isn't running
+        for (const Transform* transform = this; transform != nullptr; transform = transform->m_parent)
         {
-            m_matrix = m_matrix_local * m_parent->GetMatrix();
-        }
-        else
-        {
-            m_matrix = m_matrix_local;
+            if (transform->m_is_dirty)
+                return ComputeMatrix();
         }
 
-        // Update children
-        for (Transform* child : m_children)
-        {
-            child->UpdateTransform();
-        }
+        return m_matrix;
+    }
+
+    Matrix Transform::GetLocalMatrix() const
+    {
+        return m_is_dirty ? Matrix(m_position_local, m_rotation_local, m_scale_local) : m_matrix_local;
+    }
+
+    void Transform::MakeDirty()
+    {
+        m_is_dirty = true;
+    }
+
+    Matrix Transform::ComputeMatrix() const
+    {
+        // for reads in between hierarchy passes, the result isn't kept, that's left to UpdateHierarchy()
+        const Matrix matrix_local = Matrix(m_position_local, m_rotation_local, m_scale_local);
+        return m_parent ? matrix_local * m_parent->GetMatrix() : matrix_local;
     }
 
     void Transform::SetPosition(const Vector3& position)
@@ -139,10 +278,9 @@ namespace Spartan
         if (m_position_local == position)
             return;
 
-        m_position_local = position;
-        UpdateTransform();
-
-        m_position_changed_this_frame = true;
+        m_position_local   = position;
+        m_is_dirty         = true;
+        m_changes_pending |= change_position;
     }
 
     void Transform::SetRotation(const Quaternion& rotation)
@@ -158,10 +296,9 @@ namespace Spartan
         if (m_rotation_local == rotation)
             return;
 
-        m_rotation_local = rotation;
-        UpdateTransform();
-
-        m_rotation_changed_this_frame = true;
+        m_rotation_local   = rotation;
+        m_is_dirty         = true;
+        m_changes_pending |= change_rotation;
     }
 
     void Transform::SetScale(const Vector3& scale)
@@ -184,9 +321,8 @@ namespace Spartan
         m_scale_local.y = (m_scale_local.y == 0.0f) ? Helper::SMALL_FLOAT : m_scale_local.y;
         m_scale_local.z = (m_scale_local.z == 0.0f) ? Helper::SMALL_FLOAT : m_scale_local.z;
 
-        UpdateTransform();
-
-        m_scale_changed_this_frame = true;
+        m_is_dirty         = true;
+        m_changes_pending |= change_scale;
     }
 
     void Transform::Translate(const Vector3& delta)
@@ -317,6 +453,7 @@ namespace Spartan
         // Assign the new parent.
         m_parent   = new_parent ? new_parent.get() : nullptr;
         m_is_dirty = true;
+        mark_hierarchy_dirty();
     }
 
     void Transform::AddChild(Transform* child)
@@ -362,6 +499,7 @@ namespace Spartan
 
         // Assign the new parent.
         m_parent = new_parent;
+        mark_hierarchy_dirty();
     }
 
     void Transform::AddChild_Internal(Transform* child)
@@ -378,6 +516,7 @@ namespace Spartan
         if (!(find(m_children.begin(), m_children.end(), child) != m_children.end()))
         {
             m_children.emplace_back(child);
+            mark_hierarchy_dirty();
         }
     }
 
@@ -393,6 +532,7 @@ namespace Spartan
 
         // Remove the child
         m_children.erase(remove_if(m_children.begin(), m_children.end(), [child](Transform* vec_transform) { return vec_transform->GetObjectId() == child->GetObjectId(); }), m_children.end());
+        mark_hierarchy_dirty();
     }
 
     // Searches the entire hierarchy, finds any children and saves them in m_children.
@@ -401,6 +541,7 @@ namespace Spartan
     {
         m_children.clear();
         m_children.shrink_to_fit();
+        mark_hierarchy_dirty();
 
         auto entities = World::GetAllEntities();
         for (const auto& entity : entities)
@@ -461,13 +602,14 @@ namespace Spartan
 
     Entity* Transform::GetDescendantPtrByName(const std::string& name)
     {
-        vector<Transform*> descendants;
-        GetDescendants(&descendants);
-
-        for (Transform* transform : descendants)
+        // depth first, returns as soon as it's found
+        for (Transform* child : m_children)
         {
-            if (transform->GetEntityPtr()->GetObjectName() == name)
-                return transform->GetEntityPtr();
+            if (child->GetEntityPtr()->GetObjectName() == name)
+                return child->GetEntityPtr();
+
+            if (Entity* descendant = child->GetDescendantPtrByName(name))
+                return descendant;
         }
 
         return nullptr;
@@ -475,14 +617,8 @@ namespace Spartan
 
     weak_ptr<Entity> Transform::GetDescendantPtrWeakByName(const std::string& name)
     {
-        vector<Transform*> descendants;
-        GetDescendants(&descendants);
-
-        for (Transform* transform : descendants)
-        {
-            if (transform->GetEntityPtr()->GetObjectName() == name)
-                return transform->GetEntityPtrWeak();
-        }
+        if (Entity* descendant = GetDescendantPtrByName(name))
+            return descendant->GetTransform()->GetEntityPtrWeak();
 
         static weak_ptr<Entity> empty;
         return empty;
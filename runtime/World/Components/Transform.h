@@ -35,7 +35,7 @@ namespace Spartan
     {
     public:
         Transform(std::weak_ptr<Entity> entity);
-        ~Transform() = default;
+        ~Transform();
 
         //= ICOMPONENT ===============================
         void OnInitialize() override;
@@ -45,21 +45,21 @@ namespace Spartan
         //============================================
 
         //= POSITION ======================================================================
-        Math::Vector3 GetPosition()             const { return m_matrix.GetTranslation(); }
+        Math::Vector3 GetPosition()             const { return GetMatrix().GetTranslation(); }
         const Math::Vector3& GetPositionLocal() const { return m_position_local; }
         void SetPosition(const Math::Vector3& position);
         void SetPositionLocal(const Math::Vector3& position);
         //=================================================================================
 
         //= ROTATION ======================================================================
-        Math::Quaternion GetRotation()             const { return m_matrix.GetRotation(); }
+        Math::Quaternion GetRotation()             const { return GetMatrix().GetRotation(); }
         const Math::Quaternion& GetRotationLocal() const { return m_rotation_local; }
         void SetRotation(const Math::Quaternion& rotation);
         void SetRotationLocal(const Math::Quaternion& rotation);
         //=================================================================================
 
         //= SCALE ================================================================
-        Math::Vector3 GetScale()             const { return m_matrix.GetScale(); }
+        Math::Vector3 GetScale()             const { return GetMatrix().GetScale(); }
         const Math::Vector3& GetScaleLocal() const { return m_scale_local; }
         void SetScale(const Math::Vector3& scale);
         void SetScaleLocal(const Math::Vector3& scale);
@@ -103,11 +103,18 @@ namespace Spartan
         Transform* GetRoot()                         { return HasParent() ? GetParent()->GetRoot() : this; }
         Transform* GetParent()                 const { return m_parent; }
         std::vector<Transform*>& GetChildren()       { return m_children; }
-        void MakeDirty()                             { m_is_dirty = true; }
+        void MakeDirty();
         //==================================================================================================
 
-        const Math::Matrix& GetMatrix()                    const { return m_matrix; }
-        const Math::Matrix& GetLocalMatrix()               const { return m_matrix_local; }
+        // Resolves the world matrices of all the dirty transforms (and their descendants) in one pass, the hierarchy
+        // is kept in contiguous arrays, sorted by depth, and each level is updated in parallel.
+        // Setters only mark a transform as dirty, so the cost is paid once per frame, no matter how many times it was set.
+        static void UpdateHierarchy(const std::vector<std::shared_ptr<Entity>>& entities);
+        static void MarkHierarchyDirty(); // the set of entities changed, e.g. staged entities were committed to the world
+
+        // If anything was set since the last UpdateHierarchy(), the matrices are computed (walking up the parents) but not kept.
+        Math::Matrix GetMatrix() const;
+        Math::Matrix GetLocalMatrix() const;
         const Math::Matrix& GetMatrixPrevious()            const { return m_matrix_previous; }
         void SetMatrixPrevious(const Math::Matrix& matrix)       { m_matrix_previous = matrix;}
 
@@ -118,9 +125,10 @@ namespace Spartan
         void AddChild_Internal(Transform* child);
         void RemoveChild_Internal(Transform* child);
 
-        void UpdateTransform();
+        Math::Matrix ComputeMatrix() const;
         Math::Matrix GetParentTransformMatrix() const;
-        bool m_is_dirty = false;
+        bool m_is_dirty           = false;
+        uint8_t m_changes_pending = 0; // what the setters changed, reported by the "changed this frame" checks after the next resolve
 
         // local
         Math::Vector3 m_position_local;
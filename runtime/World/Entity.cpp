@@ -97,6 +97,14 @@ namespace Spartan
 
     Entity::~Entity()
     {
+        for (shared_ptr<Component>& component : m_components)
+        {
+            if (component)
+            {
+                ComponentStore::Remove(component.get());
+            }
+        }
+
         m_components.fill(nullptr);
     }
 
@@ -215,8 +223,8 @@ namespace Spartan
         {
             stream->Read(&m_is_active);
             stream->Read(&m_hierarchy_visibility);
-            stream->Read(&m_object_id);
-            stream->Read(&m_object_name);
+            SetObjectId(stream->ReadAs<uint64_t>());
+            SetObjectName(stream->ReadAs<string>());
         }
 
         // COMPONENTS
@@ -227,7 +235,7 @@ namespace Spartan
                 uint32_t component_type = static_cast<uint32_t>(ComponentType::Undefined);
                 stream->Read(&component_type);
 
-                if (component_type == static_cast<uint32_t>(ComponentType::Undefined))
+                if (component_type != static_cast<uint32_t>(ComponentType::Undefined))
                 {
                     // Id
                     uint64_t component_id = 0;
@@ -278,8 +286,24 @@ namespace Spartan
             GetTransform()->AcquireChildren();
         }
 
-        // Make the scene resolve
-        SP_FIRE_EVENT(EventType::WorldResolve);
+        // Let the renderer know
+        World::Resolve(shared_from_this());
+    }
+
+    void Entity::OnObjectNameChanged(const string& name_previous)
+    {
+        if (m_handle.IsValid())
+        {
+            World::OnEntityNameChanged(this, name_previous);
+        }
+    }
+
+    void Entity::OnObjectIdChanged(const uint64_t id_previous)
+    {
+        if (m_handle.IsValid())
+        {
+            World::OnEntityIdChanged(this, id_previous);
+        }
     }
 
     bool Entity::IsActiveRecursively()
@@ -329,14 +353,15 @@ namespace Spartan
                 if (id == component->GetObjectId())
                 {
                     component->OnRemove();
+                    ComponentStore::Remove(component.get());
                     component = nullptr;
                     break;
                 }
             }
         }
 
-        // Make the scene resolve
-        SP_FIRE_EVENT(EventType::WorldResolve);
+        // Let the renderer know
+        World::Resolve(shared_from_this());
     }
 
     shared_ptr<Transform> Entity::GetTransform()
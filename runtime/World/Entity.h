@@ -23,6 +23,8 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 //= INCLUDES ====================
 #include "Components/Component.h"
+#include "ComponentStore.h"
+#include "World.h"
 #include "Event.h"
 //===============================
 
@@ -30,6 +32,17 @@ namespace Spartan
 {
     class Transform;
     class Renderable;
+
+    // A slot in the world's slot map, the generation changes when the slot is released,
+    // so handles to removed entities (or to entities that reuse their slot) stop resolving.
+    struct EntityHandle
+    {
+        uint32_t index      = std::numeric_limits<uint32_t>::max();
+        uint32_t generation = 0;
+
+        bool IsValid() const { return index != std::numeric_limits<uint32_t>::max(); }
+        bool operator==(const EntityHandle& other) const { return index == other.index && generation == other.generation; }
+    };
     
     class SP_CLASS Entity : public SpObject, public std::enable_shared_from_this<Entity>
     {
@@ -60,6 +73,9 @@ namespace Spartan
         void SetActive(const bool active) { m_is_active = active; }
         bool IsActiveRecursively();
 
+        // Handle, valid for as long as the entity is part of the world
+        const EntityHandle& GetHandle() const { return m_handle; }
+
         // Visible
         bool IsVisibleInHierarchy() const                            { return m_hierarchy_visibility; }
         void SetHierarchyVisibility(const bool hierarchy_visibility) { m_hierarchy_visibility = hierarchy_visibility; }
@@ -75,7 +91,7 @@ namespace Spartan
                 return component;
 
             // Create a new component
-            std::shared_ptr<T> component = std::make_shared<T>(this->shared_from_this());
+            std::shared_ptr<T> component = ComponentStore::AllocateShared<T>(this->shared_from_this());
 
             // Save new component
             m_components[static_cast<uint32_t>(type)] = std::static_pointer_cast<Component>(component);
@@ -84,8 +100,13 @@ namespace Spartan
             component->SetType(type);
             component->OnInitialize();
 
-            // Make the scene resolve
-            SP_FIRE_EVENT(EventType::WorldResolve);
+            // Let the store and the renderer know, an entity which isn't part of the world yet (e.g. one that is
+            // still being decoded off the main thread) is added to both once it's registered
+            if (m_handle.IsValid())
+            {
+                ComponentStore::Add(component.get());
+                World::Resolve(this->shared_from_this());
+            }
 
             return component;
         }
@@ -106,16 +127,31 @@ namespace Spartan
         void RemoveComponent()
         {
             const ComponentType component_type = Component::TypeToEnum<T>();
-            m_components[static_cast<uint32_t>(component_type)] = nullptr;
-
-            SP_FIRE_EVENT(EventType::WorldResolve);
+            if (std::shared_ptr<Component>& component = m_components[static_cast<uint32_t>(component_type)])
+            {
+                ComponentStore::Remove(component.get());
+                component = nullptr;
+            }
+
+            if (m_handle.IsValid())
+            {
+                World::Resolve(this->shared_from_this());
+            }
         }
 
         void RemoveComponentById(uint64_t id);
         const auto& GetAllComponents() const { return m_components; }
         std::shared_ptr<Transform> GetTransform();
 
+    protected:
+        // keep the world's lookups in sync, no matter if the name or id is set through Entity or SpObject
+        void OnObjectNameChanged(const std::string& name_previous) override;
+        void OnObjectIdChanged(uint64_t id_previous) override;
+
     private:
+        friend class World;
+
+        EntityHandle m_handle;
         std::atomic<bool> m_is_active = true;
         bool m_hierarchy_visibility   = true;
         std::array<std::shared_ptr<Component>, 14> m_components;
@@ -32,6 +32,8 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "Components/Terrain.h"
 #include "../Resource/ResourceCache.h"
 #include "../IO/FileStream.h"
+#include "../IO/AssetFile.h"
+#include "../Core/ThreadPool.h"
 #include "../Profiling/Profiler.h"
 #include "../Physics/Car.h"
 #include "../RHI/RHI_Texture2D.h"
@@ -52,9 +54,263 @@ namespace Spartan
         static string m_name;
         static string m_file_path;
         static mutex m_entity_access_mutex;
-        static bool m_resolve            = false;
+        static atomic<bool> m_resolve    = false; // components can ask for a resolve while the world is loading in parallel
         static bool m_was_in_editor_mode = false;
 
+        // slot map, entities are packed in m_entities and handles point to slots, which point into m_entities
+        struct entity_slot
+        {
+            uint32_t dense_index = numeric_limits<uint32_t>::max(); // max while the slot is free
+            uint32_t generation  = 0;
+        };
+        static vector<entity_slot> m_entity_slots;
+        static vector<uint32_t> m_entity_slots_free;
+        static unordered_map<uint64_t, uint32_t> m_entity_id_to_slot;
+        static unordered_multimap<string, uint32_t> m_entity_name_to_slot; // names don't have to be unique
+        static mutex m_entity_lookup_mutex; // names and ids can change outside of m_entity_access_mutex
+
+        // changes since the last resolve, coalesced per entity (e.g. added and then modified is still added)
+        static unordered_map<Entity*, WorldChange> m_changes;
+        static mutex m_changes_mutex;
+
+        // The tick is split into phases, each one ticks one or more component types. A phase can only depend on phases
+        // declared before it, and a parallel phase spreads its components across the thread pool, so its components
+        // must only write to themselves, and only read transforms (which are resolved by then, so reads don't write).
+        enum class tick_phase : uint32_t
+        {
+            PhysicsSync,      // writes to transforms and to the physics world
+            Cameras,          // input can move the camera's transform
+            Transforms,       // resolves the hierarchy, no transform should be written to after this
+            Lights,           // needs the camera's view for the cascades
+            ReflectionProbes,
+            Audio             // reads the listener's transform, talks to the audio backend
+        };
+
+        struct tick_phase_desc
+        {
+            tick_phase phase;
+            vector<ComponentType> components;
+            bool parallel;
+            vector<tick_phase> dependencies;
+        };
+
+        static const vector<tick_phase_desc> tick_phases =
+        {
+            { tick_phase::PhysicsSync,      { ComponentType::PhysicsBody, ComponentType::Constraint },       false, {} },
+            { tick_phase::Cameras,          { ComponentType::Camera },                                       false, {} },
+            { tick_phase::Transforms,       {},                                                              false, { tick_phase::PhysicsSync, tick_phase::Cameras } },
+            { tick_phase::Lights,           { ComponentType::Light },                                        true,  { tick_phase::Transforms, tick_phase::Cameras } },
+            { tick_phase::ReflectionProbes, { ComponentType::ReflectionProbe },                              true,  { tick_phase::Transforms } },
+            { tick_phase::Audio,            { ComponentType::AudioSource, ComponentType::AudioListener },    false, { tick_phase::Transforms } }
+        };
+
+        static void tick_component(Component* component)
+        {
+            if (component->GetEntityPtr()->IsActive())
+            {
+                component->OnTick();
+            }
+        }
+
+        static void tick_phases_run()
+        {
+            // component types that no phase claims are ticked last, serially
+            static vector<ComponentType> unclaimed_components;
+            static once_flag validated;
+            call_once(validated, []()
+            {
+                array<bool, static_cast<uint32_t>(ComponentType::Undefined)> claimed = {};
+                for (uint32_t i = 0; i < static_cast<uint32_t>(tick_phases.size()); i++)
+                {
+                    SP_ASSERT_MSG(static_cast<uint32_t>(tick_phases[i].phase) == i, "Tick phases must be declared in order");
+                    for (tick_phase dependency : tick_phases[i].dependencies)
+                    {
+                        SP_ASSERT_MSG(static_cast<uint32_t>(dependency) < i, "A tick phase can only depend on phases declared before it");
+                    }
+
+                    for (ComponentType type : tick_phases[i].components)
+                    {
+                        claimed[static_cast<uint32_t>(type)] = true;
+                    }
+                }
+
+                for (uint32_t type = 0; type < static_cast<uint32_t>(claimed.size()); type++)
+                {
+                    if (!claimed[type])
+                    {
+                        unclaimed_components.emplace_back(static_cast<ComponentType>(type));
+                    }
+                }
+            });
+
+            for (const tick_phase_desc& desc : tick_phases)
+            {
+                if (desc.phase == tick_phase::Transforms)
+                {
+                    Transform::UpdateHierarchy(m_entities);
+                }
+
+                for (ComponentType type : desc.components)
+                {
+                    if (desc.parallel)
+                    {
+                        ComponentStore::ParallelForEach(type, tick_component);
+                    }
+                    else
+                    {
+                        ComponentStore::ForEach(type, tick_component);
+                    }
+                }
+            }
+
+            for (ComponentType type : unclaimed_components)
+            {
+                ComponentStore::ForEach(type, tick_component);
+            }
+        }
+
+        // World snapshots store one blob per entity, so that blobs can be decoded independently of each other.
+        // blob: active, visible, id, name, component count, and per component: type, id, payload size, payload
+        static void entity_to_blob(Entity* entity, vector<std::byte>* blob)
+        {
+            FileStream stream(blob);
+
+            stream.Write(entity->IsActive());
+            stream.Write(entity->IsVisibleInHierarchy());
+            stream.Write(entity->GetObjectId());
+            stream.Write(entity->GetObjectName());
+
+            uint32_t component_count = 0;
+            for (const shared_ptr<Component>& component : entity->GetAllComponents())
+            {
+                component_count += component ? 1 : 0;
+            }
+            stream.Write(component_count);
+
+            for (const shared_ptr<Component>& component : entity->GetAllComponents())
+            {
+                if (!component)
+                    continue;
+
+                stream.Write(static_cast<uint32_t>(component->GetType()));
+                stream.Write(component->GetObjectId());
+
+                // the payload size is patched in once the component has written itself
+                const size_t size_offset = blob->size();
+                stream.Write(static_cast<uint32_t>(0));
+                component->Serialize(&stream);
+                const uint32_t payload_size = static_cast<uint32_t>(blob->size() - size_offset - sizeof(uint32_t));
+                memcpy(blob->data() + size_offset, &payload_size, sizeof(uint32_t));
+            }
+        }
+
+        // adds entities and all of their descendants, parents first
+        static void entities_depth_first(const vector<Transform*>& transforms, vector<Entity*>* entities)
+        {
+            for (Transform* transform : transforms)
+            {
+                entities->emplace_back(transform->GetEntityPtr());
+                entities_depth_first(transform->GetChildren(), entities);
+            }
+        }
+
+        struct staged_component
+        {
+            ComponentType type = ComponentType::Undefined;
+            uint64_t id        = 0;
+            span<const std::byte> payload;
+        };
+
+        // an entity decoded off the main thread, it's not part of the world until it's committed
+        struct staged_entity
+        {
+            shared_ptr<Entity> entity;
+            vector<staged_component> deferred; // deserialized when committing, see is_deferred()
+            vector<std::byte> blob;            // only used if the chunk was stored compressed
+        };
+
+        // the store only holds the components of registered entities, so that nothing outside the world ticks
+        static void components_add_to_store(Entity* entity)
+        {
+            for (const shared_ptr<Component>& component : entity->GetAllComponents())
+            {
+                if (component)
+                {
+                    ComponentStore::Add(component.get());
+                }
+            }
+        }
+
+        static void components_remove_from_store(Entity* entity)
+        {
+            for (const shared_ptr<Component>& component : entity->GetAllComponents())
+            {
+                if (component)
+                {
+                    ComponentStore::Remove(component.get());
+                }
+            }
+        }
+
+        // components which read other entities or talk to the physics world, so they have to wait for the commit
+        static bool is_deferred(const ComponentType type)
+        {
+            return type == ComponentType::Transform || type == ComponentType::PhysicsBody || type == ComponentType::Constraint;
+        }
+
+        static bool entity_from_blob(span<const std::byte> blob, staged_entity* staged)
+        {
+            FileStream stream(blob);
+
+            shared_ptr<Entity> entity = make_shared<Entity>();
+            entity->Initialize();
+            entity->SetActive(stream.ReadAs<bool>());
+            entity->SetHierarchyVisibility(stream.ReadAs<bool>());
+            entity->SetObjectId(stream.ReadAs<uint64_t>());
+            entity->SetObjectName(stream.ReadAs<string>());
+
+            // create all the components first, as some depend on others when deserializing (e.g. a terrain and its renderable)
+            const uint32_t component_count = stream.ReadAs<uint32_t>();
+            vector<pair<shared_ptr<Component>, span<const std::byte>>> components;
+            components.reserve(component_count);
+            for (uint32_t i = 0; i < component_count; i++)
+            {
+                staged_component component;
+                component.type              = static_cast<ComponentType>(stream.ReadAs<uint32_t>());
+                component.id                = stream.ReadAs<uint64_t>();
+                const uint32_t payload_size = stream.ReadAs<uint32_t>();
+                component.payload           = stream.ReadView(payload_size);
+
+                if (component.type >= ComponentType::Undefined || component.payload.size() != payload_size)
+                    return false;
+
+                if (component.type == ComponentType::Transform)
+                {
+                    entity->GetTransform()->SetObjectId(component.id);
+                }
+
+                if (is_deferred(component.type))
+                {
+                    staged->deferred.emplace_back(component);
+                    continue;
+                }
+
+                shared_ptr<Component> instance = entity->AddComponent(component.type);
+                instance->SetObjectId(component.id);
+                components.emplace_back(instance, component.payload);
+            }
+
+            for (auto& [component, payload] : components)
+            {
+                FileStream payload_stream(payload);
+                component->Deserialize(&payload_stream);
+            }
+
+            staged->entity = entity;
+
+            return true;
+        }
+
         // default worlds resources
         static shared_ptr<Entity> m_default_terrain             = nullptr;
         static shared_ptr<Entity> m_default_cube                = nullptr;
@@ -481,19 +737,40 @@ namespace Spartan
                 }
             }
 
-            // Tick
-            for (shared_ptr<Entity>& entity : m_entities)
-            {
-                entity->Tick();
-            }
+            // Tick, phase by phase, iterating the packed components instead of every entity's component slots
+            tick_phases_run();
         }
 
         // Notify Renderer
         if (m_resolve)
         {
+            // a full resolve supersedes any incremental changes
+            {
+                lock_guard lock_changes(m_changes_mutex);
+                m_changes.clear();
+            }
+
             SP_FIRE_EVENT_DATA(EventType::WorldResolved, m_entities);
             m_resolve = false;
         }
+        else
+        {
+            vector<WorldChange> changes;
+            {
+                lock_guard lock_changes(m_changes_mutex);
+                changes.reserve(m_changes.size());
+                for (auto& it : m_changes)
+                {
+                    changes.emplace_back(move(it.second));
+                }
+                m_changes.clear();
+            }
+
+            if (!changes.empty())
+            {
+                SP_FIRE_EVENT_DATA(EventType::WorldChanged, changes);
+            }
+        }
     }
 
     void World::New()
@@ -516,36 +793,51 @@ namespace Spartan
         // Notify subsystems that need to save data
         SP_FIRE_EVENT(EventType::WorldSaveStart);
 
-        // Create a prefab file
-        auto file = make_unique<FileStream>(file_path, FileStream_Write);
-        if (!file->IsOpen())
+        // Create the snapshot, full buffers are written out in the background while the next chunks are added
+        AssetFileWriter file(file_path, FileStream_AsyncFlush);
+        if (!file.IsOpen())
         {
             SP_LOG_ERROR("Failed to open file.");
             return false;
         }
 
-        // Only save root entities as they will also save their descendants
-        vector<shared_ptr<Entity>> root_actors = GetRootEntities();
-        const uint32_t root_entity_count = static_cast<uint32_t>(root_actors.size());
+        // Gather all entities, parents first, so that loading can find a parent by the time its children need it
+        vector<Entity*> entities;
+        {
+            vector<Transform*> roots;
+            for (const shared_ptr<Entity>& root : GetRootEntities())
+            {
+                roots.emplace_back(root->GetTransform().get());
+            }
+            entities_depth_first(roots, &entities);
+        }
+        const uint32_t entity_count = static_cast<uint32_t>(entities.size());
 
         // Start progress tracking and timing
         const Stopwatch timer;
-        ProgressTracker::GetProgress(ProgressType::World).Start(root_entity_count, "Saving world...");
+        ProgressTracker::GetProgress(ProgressType::World).Start(entity_count, "Saving world...");
 
-        // Save root entity count
-        file->Write(root_entity_count);
+        // Encode the entities in parallel, each into its own blob
+        vector<vector<std::byte>> blobs(entity_count);
+        ThreadPool::ParallelLoop([&entities, &blobs](uint32_t start, uint32_t end)
+        {
+            for (uint32_t i = start; i < end; i++)
+            {
+                entity_to_blob(entities[i], &blobs[i]);
+            }
+        }, entity_count, 16);
 
-        // Save root entity IDs
-        for (shared_ptr<Entity>& root : root_actors)
+        // Write them out, in order
+        for (uint32_t i = 0; i < entity_count; i++)
         {
-            file->Write(root->GetObjectId());
+            file.AddChunk(AssetChunkType::Entity, i, blobs[i].data(), blobs[i].size());
+            ProgressTracker::GetProgress(ProgressType::World).JobDone();
         }
 
-        // Save root entities
-        for (shared_ptr<Entity>& root : root_actors)
+        if (!file.Close())
         {
-            root->Serialize(file.get());
-            ProgressTracker::GetProgress(ProgressType::World).JobDone();
+            SP_LOG_ERROR("Failed to write \"%s\"", file_path.c_str());
+            return false;
         }
 
         // Report time
@@ -565,12 +857,17 @@ namespace Spartan
             return false;
         }
 
-        // Open file
-        unique_ptr<FileStream> file = make_unique<FileStream>(file_path, FileStream_Read);
-        if (!file->IsOpen())
+        // Open file, worlds saved before snapshots existed aren't containers and are read the old way
+        AssetFileReader snapshot(file_path);
+        unique_ptr<FileStream> file;
+        if (!snapshot.IsOpen())
         {
-            SP_LOG_ERROR("Failed to open \"%s\"", file_path.c_str());
-            return false;
+            file = make_unique<FileStream>(file_path, FileStream_Read);
+            if (!file->IsOpen())
+            {
+                SP_LOG_ERROR("Failed to open \"%s\"", file_path.c_str());
+                return false;
+            }
         }
 
         // Clear current entities
@@ -582,34 +879,130 @@ namespace Spartan
         // Notify subsystems that need to load data
         SP_FIRE_EVENT(EventType::WorldLoadStart);
 
-        // Load root entity count
-        const uint32_t root_entity_count = file->ReadAs<uint32_t>();
-
-        // Start progress tracking and timing
-        ProgressTracker::GetProgress(ProgressType::World).Start(root_entity_count, "Loading world...");
         const Stopwatch timer;
+        bool success = true;
 
-        // Load root entity IDs
-        for (uint32_t i = 0; i < root_entity_count; i++)
+        if (snapshot.IsOpen())
         {
-            shared_ptr<Entity> entity = CreateEntity();
-            entity->SetObjectId(file->ReadAs<uint64_t>());
-        }
+            // Index the entity chunks once, so that the decoding below doesn't search the table of contents per entity
+            vector<const AssetChunkInfo*> entity_chunks;
+            for (const AssetChunkInfo& chunk : snapshot.GetChunks())
+            {
+                if (chunk.type == AssetChunkType::Entity)
+                {
+                    entity_chunks.emplace_back(&chunk);
+                }
+            }
+            const uint32_t entity_count = static_cast<uint32_t>(entity_chunks.size());
+
+            ProgressTracker::GetProgress(ProgressType::World).Start(entity_count, "Loading world...");
+
+            // Decode the blobs in parallel, into entities which aren't part of the world yet
+            vector<staged_entity> staged(entity_count);
+            atomic<bool> failed = false;
+            ThreadPool::ParallelLoop([&snapshot, &entity_chunks, &staged, &failed](uint32_t start, uint32_t end)
+            {
+                for (uint32_t i = start; i < end; i++)
+                {
+                    // entities are saved parents first, so blob i goes to slot i
+                    const AssetChunkInfo& chunk = *entity_chunks[i];
+                    span<const std::byte> blob;
+                    bool read = chunk.index == i;
+                    if (read && chunk.compression == AssetCompression::None)
+                    {
+                        read = snapshot.GetChunk(chunk, &blob);
+                    }
+                    else if (read)
+                    {
+                        staged[i].blob.resize(chunk.size_uncompressed);
+                        read = snapshot.Read(chunk, staged[i].blob.data(), staged[i].blob.size());
+                        blob = span<const std::byte>(staged[i].blob.data(), staged[i].blob.size());
+                    }
+
+                    if (!read || !entity_from_blob(blob, &staged[i]))
+                    {
+                        failed = true;
+                    }
+
+                    ProgressTracker::GetProgress(ProgressType::World).JobDone();
+                }
+            }, entity_count, 16);
+
+            if (failed)
+            {
+                // the staged entities were never registered, so dropping them is all there is to it
+                SP_LOG_ERROR("\"%s\" is corrupted", file_path.c_str());
+                success = false;
+            }
+            else
+            {
+                // Commit, in one step, the world doesn't tick while this runs
+                {
+                    lock_guard lock(m_entity_access_mutex);
+                    m_entities.reserve(entity_count);
+                    for (staged_entity& entity : staged)
+                    {
+                        RegisterEntity(entity.entity);
+                    }
+                }
+
+                // The components which need the rest of the world, parents are registered by now, in depth first
+                // order, so children are added to their parents in the order they were saved
+                for (staged_entity& entity : staged)
+                {
+                    for (const staged_component& deferred : entity.deferred)
+                    {
+                        FileStream payload(deferred.payload);
 
-        // Serialize root entities
-        for (uint32_t i = 0; i < root_entity_count; i++)
+                        if (deferred.type == ComponentType::Transform)
+                        {
+                            entity.entity->GetTransform()->Deserialize(&payload);
+                            continue;
+                        }
+
+                        shared_ptr<Component> component = entity.entity->AddComponent(deferred.type);
+                        component->SetObjectId(deferred.id);
+                        component->Deserialize(&payload);
+                    }
+                }
+            }
+        }
+        else
         {
-            static shared_ptr<Transform> empty;
-            m_entities[i]->Deserialize(file.get(), empty);
-            ProgressTracker::GetProgress(ProgressType::World).JobDone();
+            // Load root entity count
+            const uint32_t root_entity_count = file->ReadAs<uint32_t>();
+
+            // Start progress tracking
+            ProgressTracker::GetProgress(ProgressType::World).Start(root_entity_count, "Loading world...");
+
+            // Load root entity IDs
+            for (uint32_t i = 0; i < root_entity_count; i++)
+            {
+                shared_ptr<Entity> entity = CreateEntity();
+                entity->SetObjectId(file->ReadAs<uint64_t>());
+            }
+
+            // Serialize root entities
+            for (uint32_t i = 0; i < root_entity_count; i++)
+            {
+                static shared_ptr<Transform> empty;
+                m_entities[i]->Deserialize(file.get(), empty);
+                ProgressTracker::GetProgress(ProgressType::World).JobDone();
+            }
         }
 
+        // The whole world changed
+        m_resolve = true;
+
         // Report time
-        SP_LOG_INFO("World \"%s\" has been loaded. Duration %.2f ms", m_file_path.c_str(), timer.GetElapsedTimeMs());
+        if (success)
+        {
+            SP_LOG_INFO("World \"%s\" has been loaded. Duration %.2f ms", m_file_path.c_str(), timer.GetElapsedTimeMs());
+        }
 
         SP_FIRE_EVENT(EventType::WorldLoadEnd);
 
-        return true;
+        return success;
     }
 
     void World::Resolve()
@@ -617,21 +1010,177 @@ namespace Spartan
         m_resolve = true;
     }
 
+    void World::Resolve(const shared_ptr<Entity>& entity, const WorldChangeType type)
+    {
+        SP_ASSERT_MSG(entity != nullptr, "Entity is null");
+
+        lock_guard lock(m_changes_mutex);
+
+        auto it = m_changes.find(entity.get());
+        if (it == m_changes.end())
+        {
+            m_changes[entity.get()] = { entity, type };
+            return;
+        }
+
+        WorldChange& change = it->second;
+        if (type == WorldChangeType::Removed)
+        {
+            // added and removed in between resolves, the renderer never has to know
+            if (change.type == WorldChangeType::Added)
+            {
+                m_changes.erase(it);
+            }
+            else
+            {
+                change.type = WorldChangeType::Removed;
+            }
+        }
+        else if (type == WorldChangeType::Added)
+        {
+            change.type = WorldChangeType::Added;
+        }
+        // a modification doesn't change an addition (or a removal)
+    }
+
     shared_ptr<Entity> World::CreateEntity()
     {
         lock_guard lock(m_entity_access_mutex);
 
         shared_ptr<Entity> entity = make_shared<Entity>();
         entity->Initialize();
-        m_entities.emplace_back(entity);
+        RegisterEntity(entity);
+        Resolve(entity, WorldChangeType::Added);
 
         return entity;
     }
 
+    void World::RegisterEntity(const shared_ptr<Entity>& entity)
+    {
+        {
+            lock_guard lock(m_entity_lookup_mutex);
+
+            uint32_t slot_index = 0;
+            if (!m_entity_slots_free.empty())
+            {
+                slot_index = m_entity_slots_free.back();
+                m_entity_slots_free.pop_back();
+            }
+            else
+            {
+                slot_index = static_cast<uint32_t>(m_entity_slots.size());
+                m_entity_slots.emplace_back();
+            }
+
+            entity_slot& slot = m_entity_slots[slot_index];
+            slot.dense_index  = static_cast<uint32_t>(m_entities.size());
+            m_entities.emplace_back(entity);
+
+            entity->m_handle = { slot_index, slot.generation };
+            m_entity_id_to_slot[entity->GetObjectId()] = slot_index;
+            m_entity_name_to_slot.emplace(entity->GetObjectName(), slot_index);
+        }
+
+        // components added before registering (e.g. while decoding off the main thread) join the store now, so that
+        // nothing ticks or iterates a half deserialized entity
+        components_add_to_store(entity.get());
+
+        // the hierarchy pass only walks registered entities, so it has to pick this one up
+        Transform::MarkHierarchyDirty();
+    }
+
+    shared_ptr<Entity> World::UnregisterEntity(Entity* entity)
+    {
+        unique_lock lock(m_entity_lookup_mutex);
+
+        const EntityHandle handle = entity->m_handle;
+        if (!handle.IsValid())
+            return nullptr;
+
+        entity_slot& slot = m_entity_slots[handle.index];
+
+        // lookups
+        auto it_id = m_entity_id_to_slot.find(entity->GetObjectId());
+        if (it_id != m_entity_id_to_slot.end() && it_id->second == handle.index)
+        {
+            m_entity_id_to_slot.erase(it_id);
+        }
+
+        auto range = m_entity_name_to_slot.equal_range(entity->GetObjectName());
+        for (auto it = range.first; it != range.second; it++)
+        {
+            if (it->second == handle.index)
+            {
+                m_entity_name_to_slot.erase(it);
+                break;
+            }
+        }
+
+        // swap with the last entity and pop, the last entity's slot follows it
+        shared_ptr<Entity> removed = move(m_entities[slot.dense_index]);
+        if (slot.dense_index != m_entities.size() - 1)
+        {
+            m_entities[slot.dense_index] = move(m_entities.back());
+            m_entity_slots[m_entities[slot.dense_index]->m_handle.index].dense_index = slot.dense_index;
+        }
+        m_entities.pop_back();
+
+        // release the slot
+        slot.dense_index = numeric_limits<uint32_t>::max();
+        slot.generation++;
+        m_entity_slots_free.emplace_back(handle.index);
+        entity->m_handle = EntityHandle();
+        lock.unlock();
+
+        // whoever still holds the entity (e.g. the change list, until the next tick) doesn't keep it ticking
+        components_remove_from_store(entity);
+        Transform::MarkHierarchyDirty();
+
+        return removed;
+    }
+
+    void World::OnEntityIdChanged(Entity* entity, const uint64_t id_previous)
+    {
+        lock_guard lock(m_entity_lookup_mutex);
+
+        const EntityHandle handle = entity->m_handle;
+        if (!handle.IsValid())
+            return;
+
+        auto it = m_entity_id_to_slot.find(id_previous);
+        if (it != m_entity_id_to_slot.end() && it->second == handle.index)
+        {
+            m_entity_id_to_slot.erase(it);
+        }
+
+        m_entity_id_to_slot[entity->GetObjectId()] = handle.index;
+    }
+
+    void World::OnEntityNameChanged(Entity* entity, const string& name_previous)
+    {
+        lock_guard lock(m_entity_lookup_mutex);
+
+        const EntityHandle handle = entity->m_handle;
+        if (!handle.IsValid())
+            return;
+
+        auto range = m_entity_name_to_slot.equal_range(name_previous);
+        for (auto it = range.first; it != range.second; it++)
+        {
+            if (it->second == handle.index)
+            {
+                m_entity_name_to_slot.erase(it);
+                break;
+            }
+        }
+
+        m_entity_name_to_slot.emplace(entity->GetObjectName(), handle.index);
+    }
+
     bool World::EntityExists(Entity* entity)
     {
         SP_ASSERT_MSG(entity != nullptr, "Entity is null");
-        return GetEntityById(entity->GetObjectId()) != nullptr;
+        return GetEntityByHandle(entity->GetHandle()).get() == entity;
     }
 
     void World::RemoveEntity(shared_ptr<Entity> entity_to_remove)
@@ -647,29 +1196,21 @@ namespace Spartan
             entities_to_remove.push_back(entity_to_remove->GetTransform().get());  // Add the root entity
             entity_to_remove->GetTransform()->GetDescendants(&entities_to_remove); // Get descendants 
 
-            // Create a set containing the object IDs of entities to remove
-            set<uint64_t> ids_to_remove;
+            // Detach from the parent (if any)
+            entity_to_remove->GetTransform()->SetParent(nullptr);
+
+            // Remove entities, each one is swapped with the last and popped
+            vector<shared_ptr<Entity>> removed;
+            removed.reserve(entities_to_remove.size());
             for (Transform* transform : entities_to_remove)
             {
-                ids_to_remove.insert(transform->GetEntityPtr()->GetObjectId());
-            }
-
-            // Remove entities using a single loop
-            m_entities.erase(remove_if(m_entities.begin(), m_entities.end(),
-                [&](const shared_ptr<Entity>& entity)
+                removed.emplace_back(UnregisterEntity(transform->GetEntityPtr()));
+                if (removed.back())
                 {
-                    return ids_to_remove.count(entity->GetObjectId()) > 0;
-                }),
-                m_entities.end());
-
-            // If there was a parent, update it
-            if (Transform* parent = entity_to_remove->GetTransform()->GetParent())
-            {
-                parent->AcquireChildren();
+                    Resolve(removed.back(), WorldChangeType::Removed);
+                }
             }
         }
-
-        m_resolve = true;
     }
 
     vector<shared_ptr<Entity>> World::GetRootEntities()
@@ -691,12 +1232,11 @@ namespace Spartan
     const shared_ptr<Entity>& World::GetEntityByName(const string& name)
     {
         lock_guard<mutex> lock(m_entity_access_mutex);
+        lock_guard<mutex> lock_lookup(m_entity_lookup_mutex);
 
-        for (shared_ptr<Entity>& entity : m_entities)
-        {
-            if (entity->GetObjectName() == name)
-                return entity;
-        }
+        auto it = m_entity_name_to_slot.find(name);
+        if (it != m_entity_name_to_slot.end())
+            return m_entities[m_entity_slots[it->second].dense_index];
 
         static shared_ptr<Entity> empty;
         return empty;
@@ -705,11 +1245,26 @@ namespace Spartan
     const shared_ptr<Entity>& World::GetEntityById(const uint64_t id)
     {
         lock_guard<mutex> lock(m_entity_access_mutex);
+        lock_guard<mutex> lock_lookup(m_entity_lookup_mutex);
+
+        auto it = m_entity_id_to_slot.find(id);
+        if (it != m_entity_id_to_slot.end())
+            return m_entities[m_entity_slots[it->second].dense_index];
+
+        static shared_ptr<Entity> empty;
+        return empty;
+    }
+
+    const shared_ptr<Entity>& World::GetEntityByHandle(const EntityHandle& handle)
+    {
+        lock_guard<mutex> lock(m_entity_access_mutex);
+        lock_guard<mutex> lock_lookup(m_entity_lookup_mutex);
 
-        for (const auto& entity : m_entities)
+        if (handle.IsValid() && handle.index < m_entity_slots.size())
         {
-            if (entity->GetObjectId() == id)
-                return entity;
+            const entity_slot& slot = m_entity_slots[handle.index];
+            if (slot.generation == handle.generation && slot.dense_index != numeric_limits<uint32_t>::max())
+                return m_entities[slot.dense_index];
         }
 
         static shared_ptr<Entity> empty;
@@ -726,8 +1281,32 @@ namespace Spartan
         // Fire event
         SP_FIRE_EVENT(EventType::WorldClear);
 
-        // Clear
+        // Clear, releasing all the slots so that existing handles stop resolving
+        {
+            lock_guard<mutex> lock_lookup(m_entity_lookup_mutex);
+
+            for (shared_ptr<Entity>& entity : m_entities)
+            {
+                entity_slot& slot = m_entity_slots[entity->m_handle.index];
+                slot.dense_index  = numeric_limits<uint32_t>::max();
+                slot.generation++;
+                m_entity_slots_free.emplace_back(entity->m_handle.index);
+                entity->m_handle = EntityHandle();
+            }
+
+            m_entity_id_to_slot.clear();
+            m_entity_name_to_slot.clear();
+        }
+        for (shared_ptr<Entity>& entity : m_entities)
+        {
+            components_remove_from_store(entity.get());
+        }
         m_entities.clear();
+
+        {
+            lock_guard lock_changes(m_changes_mutex);
+            m_changes.clear();
+        }
         m_name.clear();
         m_file_path.clear();
 
@@ -23,11 +23,14 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 //= INCLUDES ===============
 #include "Definitions.h"
+#include "Event.h"
 #include "../Math/Vector3.h"
 //==========================
 
 namespace Spartan
 {
+    struct EntityHandle;
+
     class SP_CLASS World
     {
     public:
@@ -44,6 +47,8 @@ namespace Spartan
         // misc
         static void New();
         static void Resolve();
+        // Records a change to a single entity, the renderer applies these incrementally instead of resolving everything
+        static void Resolve(const std::shared_ptr<Entity>& entity, WorldChangeType type = WorldChangeType::Modified);
         static const std::string GetName();
         static const std::string& GetFilePath();
 
@@ -62,9 +67,20 @@ namespace Spartan
         static std::vector<std::shared_ptr<Entity>> GetRootEntities();
         static const std::shared_ptr<Entity>& GetEntityByName(const std::string& name);
         static const std::shared_ptr<Entity>& GetEntityById(uint64_t id);
+        static const std::shared_ptr<Entity>& GetEntityByHandle(const EntityHandle& handle);
         static const std::vector<std::shared_ptr<Entity>>& GetAllEntities();
 
     private:
+        friend class Entity;
+
         static void Clear();
+
+        // slot map bookkeeping, the caller holds the entity access mutex
+        static void RegisterEntity(const std::shared_ptr<Entity>& entity);
+        static std::shared_ptr<Entity> UnregisterEntity(Entity* entity);
+
+        // keep the id and name lookups in sync, called by the entity
+        static void OnEntityIdChanged(Entity* entity, uint64_t id_previous);
+        static void OnEntityNameChanged(Entity* entity, const std::string& name_previous);
     };
 }